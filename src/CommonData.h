@@ -46,4 +46,10 @@ inline struct CommonData {
     config<bool>         annoy   = { "Annoy"  , false };
     config<MyPreference> myPref  = { "MyPreference", MyPreference::Bacon };
 
+    config<int>  refreshLatency   = { "Refresh latency"       , 50    };  // maximum milliseconds before dialogs show changes
+    config<bool> watcherMarkAll   = { "Watcher marks all"     , false };
+    config<int>  watcherThreads   = { "Watcher search threads", 0     };  // 0 for one per processor; 1 for sequential search
+    config<bool> measureLatency   = { "Measure latency"       , false };  // enables Instrumentation
+    config<int>  autosaveInterval = { "Autosave seconds"      , 60    };  // 0 to save only at shutdown
+
 } data;
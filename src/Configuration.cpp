@@ -15,8 +15,14 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "CommonData.h"
+#include "Framework/MappedFile.h"
+#include "Framework/TaskPool.h"
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include "Shlwapi.h"
 
 namespace {
@@ -25,12 +31,33 @@ namespace {
 
     constexpr int configVersion    = 1;  // version of configuration file expected and generated by this plugin version
     constexpr int configCompatible = 1;  // lowest configuration code version that can read files from this plugin version
+    constexpr bool configCompact   = false;  // write without indentation: faster for large stores, harder to read
+    constexpr bool configCache     = false;  // keep a binary (CBOR) copy beside the file, for faster loading
 
     std::wstring filePath;
     bool configFound = false;
     bool configIgnored = false;
     std::filesystem::file_time_type lastWriteTime;
 
+    std::mutex        writing;                  // held while writing the file or using the three values above
+    UINT_PTR          autosaveTimer   = 0;
+    std::atomic<bool> autosaving      = false;  // an autosave is queued or being written
+    std::atomic<bool> autosaveBlocked = false;  // the file was ignored or edited elsewhere: leave it for shutdown
+
+    // Show a warning from readConfiguration, which might be running on a background thread
+
+    void warn(const wchar_t* text) {
+        taskPool.postToUi([text] { MessageBox(plugin.nppData._nppHandle, text, L"$projectname$", MB_ICONWARNING); });
+    }
+
+    void readConfiguration();
+    void configurationLoaded();
+    void stamp();
+    bool editedElsewhere();
+    bool readCache(nlohmann::json& saved);
+    void writeCache(const nlohmann::json& saved);
+    bool writeConfiguration(const nlohmann::json& snapshot, uint64_t version);
+
 }
 
 using json = nlohmann::json;
@@ -38,34 +65,51 @@ using json = nlohmann::json;
 json configuration;
 
 
-void loadConfiguration() {
+// loadConfiguration is called while Notepad++ is building its menus.  The menus don't depend on any settings, so it
+// only gets the configuration directory (which requires a message to Notepad++) and defers reading the file to
+// readConfiguration, which NPPN_READY starts on a background thread; configurationLoaded then runs on the user
+// interface thread.
 
+void loadConfiguration() {
     filePath.resize(npp(NPPM_GETPLUGINSCONFIGDIR, 0, 0), 0);
     npp(NPPM_GETPLUGINSCONFIGDIR, filePath.length() + 1, filePath.data());
+    ConfigurationLoad::defer([] {
+        readConfiguration();
+        taskPool.postToUi(configurationLoaded);
+    });
+}
+
+
+namespace {
+
+void readConfiguration() {
+
+    Instrumentation::Scope timing(Instrumentation::Kind::Configuration, 0, "readConfiguration");
+
     if (PathFileExists(filePath.data()) == FALSE) if (!CreateDirectory(filePath.data(), NULL)) return;
     filePath += L"\\$projectname$.json";
-    std::ifstream file(filePath);
+    MappedFile file(filePath);
     if (!file) return;
 
     configFound = true;
     std::error_code ec;
     lastWriteTime = std::filesystem::last_write_time(filePath, ec);
 
-    json saved = json::parse(file, 0, false, true);
+    json saved;
+    if (!readCache(saved)) {
+        saved = json::parse(file.begin(), file.end(), 0, false, true);
+        if (!saved.is_discarded()) writeCache(saved);
+    }
 
     if (saved.is_discarded()) {
-        MessageBox(plugin.nppData._nppHandle,
-            L"A configuration file was found, but it does not contain valid JSON and will be ignored.",
-            L"$projectname$", MB_ICONWARNING);
+        warn(L"A configuration file was found, but it does not contain valid JSON and will be ignored.");
         configIgnored = true;
         return;
     }
 
     if (!saved.contains("*ConfigurationFor*") || !saved["*ConfigurationFor*"].is_string() 
       || saved["*ConfigurationFor*"] != configFor) {
-        MessageBox(plugin.nppData._nppHandle,
-            L"A configuration file was found, but it does not appear to be for this plugin and will be ignored.",
-            L"$projectname$", MB_ICONWARNING);
+        warn(L"A configuration file was found, but it does not appear to be for this plugin and will be ignored.");
         configIgnored = true;
         return;
     }
@@ -73,9 +117,7 @@ void loadConfiguration() {
     if (saved.contains("*ConfigurationCompatibleVersion*")) {
          const auto& ccv = saved["*ConfigurationCompatibleVersion*"];
          if (!ccv.is_number() || ccv.get<int>() > configVersion) {
-             MessageBox(plugin.nppData._nppHandle,
-                 L"A configuration file was found, but it is for a newer version of this plugin and will be ignored.",
-                 L"$projectname$", MB_ICONWARNING);
+             warn(L"A configuration file was found, but it is for a newer version of this plugin and will be ignored.");
              configIgnored = true;
              return;
          }
@@ -86,15 +128,142 @@ void loadConfiguration() {
 
     configuration.merge_patch(saved);
 
+}
+
+
+// Autosave: every data.autosaveInterval seconds, if any setting has changed, copy the store on the user interface
+// thread and write the copy on a worker thread, so a crash loses at most one interval of changes.  However many
+// changes are made in an interval, they are written once.  Autosave never asks questions: if the file found at
+// startup was ignored, or the file has been edited by something else, autosave stops and saveConfiguration asks
+// at shutdown as usual.
+
+void CALLBACK autosave(HWND, UINT, UINT_PTR, DWORD) {
+    if (autosaving || autosaveBlocked) return;
+    ConfigRegistry::store();
+    if (!ConfigurationChange::any()) return;
+    autosaving = true;
+    stamp();
+    auto snapshot = std::make_shared<const json>(configuration);
+    uint64_t version = ConfigurationChange::version();
+    taskPool.submit([snapshot, version] {
+        Instrumentation::Scope timing(Instrumentation::Kind::Configuration, 0, "autosave");
+        {
+            std::lock_guard lock(writing);
+            if (configIgnored || editedElsewhere()) autosaveBlocked = true;
+            else writeConfiguration(*snapshot, version);
+        }
+        autosaving = false;
+    });
+}
+
+
+// Runs on the user interface thread after the configuration has been read.
+
+void configurationLoaded() {
+
     // If there are settings you want to copy immediately from the JSON store (configuration)
     // to program storage, do that here.
 
+    Instrumentation::enabled = data.measureLatency.get();
+
+    int interval = std::min(data.autosaveInterval.get(), 24 * 60 * 60);
+    if (interval > 0) autosaveTimer = SetTimer(0, 0, interval * 1000, autosave);
+
+}
+
+
+void stamp() {
+    configuration["*ConfigurationFor*"              ] = configFor;
+    configuration["*ConfigurationVersion*"          ] = configVersion;
+    configuration["*ConfigurationCompatibleVersion*"] = configCompatible;
+}
+
+
+bool editedElsewhere() {
+    if (!configFound) return false;
+    std::error_code ec;
+    return lastWriteTime != std::filesystem::last_write_time(filePath, ec);
+}
+
+
+// Write to a temporary file, flush it to disk and rename it over the configuration file, so an interrupted save
+// leaves the previous file intact.  The caller must hold the writing mutex.
+
+bool writeConfiguration(const json& snapshot, uint64_t version) {
+    std::string text = snapshot.dump(configCompact ? -1 : 4, ' ', false, json::error_handler_t::replace);
+    std::wstring tempPath = filePath + L".tmp";
+    HANDLE file = CreateFile(tempPath.data(), GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    bool ok = WriteFile(file, text.data(), static_cast<DWORD>(text.size()), &written, 0)
+           && written == text.size() && FlushFileBuffers(file);
+    CloseHandle(file);
+    if (ok) ok = MoveFileEx(tempPath.data(), filePath.data(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    if (!ok) {
+        DeleteFile(tempPath.data());
+        return false;
+    }
+    ConfigurationChange::clear(version);
+    configFound   = true;
+    configIgnored = false;
+    std::error_code ec;
+    lastWriteTime = std::filesystem::last_write_time(filePath, ec);
+    writeCache(snapshot);
+    return true;
 }
 
 
+// The binary cache, <file>.cbor, is a CBOR array of the configuration file's size, its last write time and its
+// parsed contents.  The JSON file remains the source of truth: the cache is used only when the size and time match,
+// and is rewritten whenever the file is parsed or saved.  A cache which is missing, damaged or stale is ignored.
+
+bool readCache(json& saved) {
+    if constexpr (!configCache) return false;
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(filePath, ec);
+    if (ec) return false;
+    MappedFile file(filePath + L".cbor");
+    if (!file) return false;
+    json cache = json::from_cbor(file.begin(), file.end(), true, false);
+    if (cache.is_discarded() || !cache.is_array() || cache.size() != 3
+     || cache[0] != size || cache[1] != lastWriteTime.time_since_epoch().count()) return false;
+    saved = std::move(cache[2]);
+    return true;
+}
+
+void writeCache(const json& saved) {
+    if constexpr (!configCache) return;
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(filePath, ec);
+    if (ec) return;
+    std::ofstream file(filePath + L".cbor", std::ios::binary | std::ios::trunc);
+    if (!file) return;
+    file.put(static_cast<char>(0x83));  // CBOR header for an array of three items
+    json::to_cbor(json(size), file);
+    json::to_cbor(json(lastWriteTime.time_since_epoch().count()), file);
+    json::to_cbor(saved, file);
+}
+
+}
+
+
+// saveConfiguration is the final save, at shutdown; it stops autosave, waits for any autosave in progress and asks
+// before overwriting a file that was ignored at startup or edited during the session.
+
 void saveConfiguration() {
 
-    // If you have settings that are not copied to the JSON store whenever they change, copy them here.
+    Instrumentation::Scope timing(Instrumentation::Kind::Configuration, 0, "saveConfiguration");
+    ConfigurationLoad::wait();
+    if (autosaveTimer) KillTimer(0, autosaveTimer);
+    autosaveTimer = 0;
+
+    // If you have settings that are not managed by config, config_history or config_rect, copy them to the
+    // JSON store here, and call ConfigurationChange::mark() if any of them changed.
+
+    ConfigRegistry::store();
+    if (!ConfigurationChange::any()) return;
+
+    std::lock_guard lock(writing);
 
     if (configFound) {
         if (configIgnored) {
@@ -103,24 +272,62 @@ void saveConfiguration() {
                 L"Do you want to save the current configuration settings? (If Yes, the old file will be overwritten.)",
                 L"$projectname$", MB_YESNO | MB_ICONWARNING) == IDNO) return;
         }
-        else {
-            std::error_code ec;
-            if (lastWriteTime != std::filesystem::last_write_time(filePath, ec)) {
-                if (MessageBox(plugin.nppData._nppHandle,
-                    L"It looks like the configuration file for this plugin was edited during this session.\n\n"
-                    L"Do you want to save the current configuration settings? (If Yes, the edited file will be overwritten.)",
-                    L"$projectname$", MB_YESNO | MB_DEFBUTTON2 | MB_ICONWARNING) == IDNO) return;
-            }
+        else if (editedElsewhere()) {
+            if (MessageBox(plugin.nppData._nppHandle,
+                L"It looks like the configuration file for this plugin was edited during this session.\n\n"
+                L"Do you want to save the current configuration settings? (If Yes, the edited file will be overwritten.)",
+                L"$projectname$", MB_YESNO | MB_DEFBUTTON2 | MB_ICONWARNING) == IDNO) return;
         }
     }
 
-    std::ofstream file(filePath);
+    stamp();
+    writeConfiguration(configuration, ConfigurationChange::version());
+
+}
+
+
+// Write the events recorded by Trace to a file beside the configuration file; returns the path, or an empty string
+// if the file could not be written.
+
+std::wstring saveTrace() {
+    ConfigurationLoad::wait();
+    if (filePath.length() < 5 || filePath.substr(filePath.length() - 5) != L".json") return L"";
+    std::wstring tracePath = filePath.substr(0, filePath.length() - 5) + L".trace.json";
+    std::ofstream file(tracePath);
+    if (!file) return L"";
+    Trace::write(file);
+    return file ? tracePath : L"";
+}
+
+
+// Write the measurements collected by Instrumentation, slowest (by 99th percentile) first, to a file beside the
+// configuration file.
+
+void saveInstrumentation() {
+
+    ConfigurationLoad::wait();
+    if (filePath.length() < 5 || filePath.substr(filePath.length() - 5) != L".json") return;
+    std::ofstream file(filePath.substr(0, filePath.length() - 5) + L".instrumentation.json");
     if (!file) return;
 
-    configuration["*ConfigurationFor*"              ] = configFor;
-    configuration["*ConfigurationVersion*"          ] = configVersion;
-    configuration["*ConfigurationCompatibleVersion*"] = configCompatible;
+    std::vector<Instrumentation::Summary> events = Instrumentation::snapshot();
+    std::sort(events.begin(), events.end(), [](const auto& a, const auto& b) { return a.p99 > b.p99; });
+
+    json report;
+    report["*InstrumentationFor*"] = configFor;
+    report["events"] = json::array();
+    for (const Instrumentation::Summary& event : events) {
+        json& e = report["events"].emplace_back();
+        e["kind"] = Instrumentation::kindName(event.kind);
+        if (event.name) e["name"] = event.name;
+        else            e["id"  ] = event.id;
+        e["count"            ] = event.count;
+        e["p50Microseconds"  ] = event.p50;
+        e["p99Microseconds"  ] = event.p99;
+        e["maxMicroseconds"  ] = event.max;
+        e["totalMicroseconds"] = event.total;
+    }
 
-    file << std::setw(4) << configuration;
+    file << std::setw(4) << report;
 
-}
\ No newline at end of file
+}
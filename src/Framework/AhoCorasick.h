@@ -0,0 +1,162 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// AhoCorasick finds every occurrence of any of a set of byte strings in one pass over the text, taking the same time
+// per byte however many strings there are.  The automaton is stored as a dense transition table: bytes which occur
+// in no term share a single column, so the table has one row per trie node and one column per distinct byte used.
+//
+// scan may be called repeatedly with consecutive pieces of a text, passing the state returned by each call to the
+// next; occurrences which span pieces are found as if the text were contiguous.  It calls f(term, end) for each
+// occurrence, where term is the index of the term in the list given to build and end is the offset (plus base) just
+// past the end of the occurrence.  Occurrences are reported in order of their ends; when several terms end at the
+// same place, longer terms are reported first.  Empty terms are never reported.
+//
+// When build is called with matchCase false, the ASCII letters A-Z and a-z match either case; this costs nothing
+// when scanning, since each upper case letter is given the same column as its lower case counterpart.  Other bytes
+// always match exactly, so letters outside ASCII (in any code page, and in UTF-8) are still case-sensitive.
+//
+// This file depends only on the standard library.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+class AhoCorasick {
+
+    std::array<uint16_t, 256> classOf = {};  // column for each byte value; 0 for bytes which occur in no term
+    size_t                    classes = 1;   // up to 257, when the terms use every byte value
+    std::vector<uint32_t>     next;          // next[state * classes + class]
+    std::vector<uint32_t>     outFirst;      // terms matched at state s are outTerms[outFirst[s]] to outTerms[outFirst[s+1]-1]
+    std::vector<uint32_t>     outTerms;
+    std::vector<std::string>  list;
+    bool                      exact   = true;  // false when ASCII letters match either case
+
+public:
+
+    using State = uint32_t;
+    static constexpr State start = 0;
+
+    AhoCorasick() { build({}); }
+    explicit AhoCorasick(const std::vector<std::string>& terms, bool matchCase = true) { build(terms, matchCase); }
+
+    static constexpr char fold(char c) noexcept { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+    void build(const std::vector<std::string>& terms, bool matchCase = true) {
+
+        constexpr uint32_t none = UINT32_MAX;
+
+        classOf.fill(0);
+        classes = 1;
+        list = terms;
+        exact = matchCase;
+        for (const std::string& t : terms) {
+            for (char c : t) {
+                uint8_t b = static_cast<uint8_t>(matchCase ? c : fold(c));
+                if (!classOf[b]) classOf[b] = static_cast<uint16_t>(classes++);
+            }
+        }
+        if (!matchCase) for (char c = 'A'; c <= 'Z'; ++c) classOf[static_cast<uint8_t>(c)] = classOf[static_cast<uint8_t>(fold(c))];
+
+        // Trie
+
+        next.assign(classes, none);
+        std::vector<std::vector<uint32_t>> own(1);
+        for (uint32_t i = 0; i < terms.size(); ++i) {
+            if (terms[i].empty()) continue;
+            uint32_t s = 0;
+            for (char c : terms[i]) {
+                uint32_t& t = next[s * classes + classOf[static_cast<uint8_t>(c)]];
+                if (t == none) {
+                    t = static_cast<uint32_t>(own.size());
+                    own.emplace_back();
+                    next.resize(next.size() + classes, none);
+                }
+                s = next[s * classes + classOf[static_cast<uint8_t>(c)]];  // t may be invalid after resize
+            }
+            own[s].push_back(i);
+        }
+
+        // Breadth-first completion of the transition table; each state's output includes that of its failure state
+
+        const size_t states = own.size();
+        std::vector<uint32_t> fail(states, 0);
+        std::vector<uint32_t> order;
+        order.reserve(states);
+        order.push_back(0);
+        for (size_t c = 0; c < classes; ++c) {
+            uint32_t& t = next[c];
+            if (t == none) t = 0;
+            else order.push_back(t);
+        }
+        for (size_t k = 1; k < order.size(); ++k) {
+            const uint32_t s = order[k];
+            for (size_t c = 0; c < classes; ++c) {
+                uint32_t& t = next[s * classes + c];
+                if (t == none) t = next[fail[s] * classes + c];
+                else {
+                    fail[t] = next[fail[s] * classes + c];
+                    order.push_back(t);
+                }
+            }
+        }
+        for (size_t k = 1; k < order.size(); ++k) {
+            const uint32_t s = order[k];
+            if (fail[s]) own[s].insert(own[s].end(), own[fail[s]].begin(), own[fail[s]].end());
+        }
+
+        outFirst.assign(states + 1, 0);
+        outTerms.clear();
+        for (size_t s = 0; s < states; ++s) {
+            outFirst[s] = static_cast<uint32_t>(outTerms.size());
+            outTerms.insert(outTerms.end(), own[s].begin(), own[s].end());
+        }
+        outFirst[states] = static_cast<uint32_t>(outTerms.size());
+
+    }
+
+    size_t             terms()              const noexcept { return list.size(); }
+    const std::string& term(size_t i)       const noexcept { return list[i]; }
+    size_t             termLength(size_t i) const noexcept { return list[i].length(); }
+    size_t             longest()            const noexcept { size_t n = 0; for (auto& t : list) if (t.length() > n) n = t.length(); return n; }
+    bool               empty()              const noexcept { return outTerms.empty(); }
+    bool               matchCase()          const noexcept { return exact; }
+
+    template<typename F> State scan(std::string_view text, F&& f, State state = start, size_t base = 0) const {
+        const uint32_t* table = next.data();
+        const uint8_t*  p     = reinterpret_cast<const uint8_t*>(text.data());
+        const size_t    n     = text.length();
+        for (size_t i = 0; i < n; ++i) {
+            if (state == start) {
+                while (i < n && !classOf[p[i]]) ++i;  // bytes which occur in no term
+                if (i == n) break;
+            }
+            state = table[state * classes + classOf[p[i]]];
+            for (uint32_t k = outFirst[state]; k < outFirst[state + 1]; ++k) f(static_cast<size_t>(outTerms[k]), base + i + 1);
+        }
+        return state;
+    }
+
+};
@@ -24,7 +24,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #define NOMINMAX
 #include <windows.h>
@@ -44,6 +49,175 @@ template<typename T>bool equalExceptTrailing(T s1, T s2) {
 
 extern nlohmann::json configuration;  // persistent data (in sample project, instantiated and read/written in Configuration.cpp)
 
+
+// ConfigurationLoad lets the configuration file be read on a background thread, away from Notepad++ startup.  Call
+// defer with the routine that reads the file into the store, then start (e.g., at NPPN_READY) to run it on a new
+// thread.  Until it finishes, config, config_history and config_rect wait before reading or writing their stores.
+// If a setting is needed before start is called, the routine runs at once on the thread that needs it.  The routine
+// itself must not use config values with the store it is loading.
+
+class ConfigurationLoad {
+
+    enum State { Done, Pending, Running };
+
+    static inline std::atomic<int>        state = Done;
+    static inline void                    (*load)() = 0;
+    static inline std::mutex              mutex;
+    static inline std::condition_variable finished;
+
+    static bool claim() { int expected = Pending; return state.compare_exchange_strong(expected, Running); }
+
+    static void run() {
+        try { load(); } catch (...) {}
+        {
+            std::lock_guard lock(mutex);
+            state = Done;
+        }
+        finished.notify_all();
+    }
+
+public:
+
+    static void defer(void (*routine)()) {
+        load  = routine;
+        state = Pending;
+    }
+
+    static void start() { if (claim()) std::thread(run).detach(); }
+
+    static void wait() {
+        if (state.load(std::memory_order_acquire) == Done) return;
+        if (claim()) {
+            run();
+            return;
+        }
+        std::unique_lock lock(mutex);
+        finished.wait(lock, [] { return state.load() == Done; });
+    }
+
+    static nlohmann::json& wait(nlohmann::json& store) { wait(); return store; }
+
+};
+
+
+// ConfigurationChange records whether any setting in a JSON store has changed since the configuration was read or last
+// saved, so saving can be skipped when the file would be unchanged.  config, config_history and config_rect write to
+// their stores (when ConfigRegistry::store is called) through ConfigurationChange::store, which only marks a change
+// when the stored value differs.  If you modify a store directly, call ConfigurationChange::mark.  Each change advances a version number; a save made from a
+// copy of the store taken at version v calls clear(v), so changes made while the copy was being written stay pending.
+
+class ConfigurationChange {
+
+    static inline std::atomic<uint64_t> changes = 0;
+    static inline std::atomic<uint64_t> saved   = 0;
+
+public:
+
+    static void store(nlohmann::json& j, std::string_view n, nlohmann::json v) {
+        nlohmann::json& slot = j[n];
+        if (slot == v) return;
+        slot = std::move(v);
+        ++changes;
+    }
+
+    static void     mark()    { ++changes; }
+    static bool     any()     { return changes != saved; }
+    static uint64_t version() { return changes; }
+    static void     clear()   { clear(changes); }
+
+    static void clear(uint64_t v) {
+        uint64_t current = saved;
+        while (current < v && !saved.compare_exchange_weak(current, v));
+    }
+
+};
+
+
+// ConfigRegistry keeps the values of config, config_history and config_rect variables out of their JSON stores except
+// when the configuration is loaded and saved.  Each variable that has a store is registered when it is constructed and
+// gets a dense integer id; its value lives in the variable itself, in its native type.  Reading a setting touches the
+// JSON store only the first time; assigning to it just marks its id as changed.  ConfigRegistry::store copies the
+// values of the changed variables to their stores; the configuration save routines call it before checking
+// ConfigurationChange::any.  Use it only on the user interface thread.
+
+class ConfigRegistry {
+
+public:
+
+    using Store = void(*)(void*);
+
+    static constexpr size_t none = SIZE_MAX;
+
+    static size_t add(void* entry, Store store) {
+        table().slots.push_back({ entry, store, false });
+        return table().slots.size() - 1;
+    }
+
+    static void remove(size_t id) { table().slots[id] = {}; }
+
+    static void changed(size_t id) {
+        Slot& slot = table().slots[id];
+        if (slot.pending) return;
+        slot.pending = true;
+        table().pending.push_back(id);
+    }
+
+    static void store() {
+        Table& t = table();
+        for (size_t id : t.pending) {
+            Slot& slot = t.slots[id];
+            if (!slot.pending) continue;  // removed
+            slot.pending = false;
+            slot.store(slot.entry);
+        }
+        t.pending.clear();
+    }
+
+private:
+
+    struct Slot {
+        void* entry   = 0;
+        Store store   = 0;
+        bool  pending = false;
+    };
+
+    struct Table {
+        std::vector<Slot>   slots;
+        std::vector<size_t> pending;
+    };
+
+    static Table& table() { static Table t; return t; }  // constructed on first use, so static variables can register
+
+};
+
+// ConfigRegistered is the base through which config, config_history and config_rect register with ConfigRegistry.
+// A copy of a registered variable is registered separately.
+
+template<typename Entry> class ConfigRegistered {
+
+    size_t id = ConfigRegistry::none;
+
+    static void store(void* entry) { static_cast<Entry*>(entry)->save(); }
+
+protected:
+
+    void enroll()  { id = ConfigRegistry::add(static_cast<Entry*>(this), store); }
+    void changed() { if (id != ConfigRegistry::none) ConfigRegistry::changed(id); }
+
+    ConfigRegistered() = default;
+    ConfigRegistered(const ConfigRegistered& other) { if (other.id != ConfigRegistry::none) enroll(); }
+
+    ConfigRegistered& operator=(const ConfigRegistered& other) {
+        if (id == ConfigRegistry::none && other.id != ConfigRegistry::none) enroll();
+        changed();
+        return *this;
+    }
+
+    ~ConfigRegistered() { if (id != ConfigRegistry::none) ConfigRegistry::remove(id); }
+
+};
+
+
 // Specialization of nlohmann::adl_serializer for std::wstring
 
 namespace nlohmann {
@@ -71,7 +245,9 @@ namespace nlohmann {
 
 // Definition of template "config"
 
-template<typename T> struct config {
+template<typename T> struct config : ConfigRegistered<config<T>> {
+
+    using ConfigRegistered<config<T>>::changed;
 
     std::string name;
     nlohmann::json* store;
@@ -90,21 +266,23 @@ template<typename T> struct config {
     static void show(HWND w, int id, const T& v) { return show(GetDlgItem(w, id), v); }
 
     T& get(const nlohmann::json& j, std::string_view n) { loaded |= peek(value, j, n); return value; }
-    T& get(HWND w)         { if (peek(value, w)) { loaded = true; if (store && !name.empty()) put(*store, name); } return value; }
+    T& get(HWND w)         { if (peek(value, w)) { loaded = true; changed(); } return value; }
     T& get(HWND w, int id) { return get(GetDlgItem(w, id)); }
-    T& get()               { if (!loaded && store && !name.empty()) { get(*store, name); loaded = true; } return value; }
+    T& get()               { if (!loaded && store && !name.empty()) { get(ConfigurationLoad::wait(*store), name); loaded = true; } return value; }
 
-    const T& put(nlohmann::json& j, std::string_view n) const { j[n] = value; return value; }
+    const T& put(nlohmann::json& j, std::string_view n) const { ConfigurationChange::store(j, n, value); return value; }
     const T& put(HWND w)                                      { show(w, get()); return value; }
     const T& put(HWND w, int id)                              { return put(GetDlgItem(w, id)); }
 
+    void save() { if (loaded && store && !name.empty()) put(*store, name); }  // called by ConfigRegistry::store
+
     operator T&()                    { return get(); }
-    config<T>& operator=(const T& v) { value = v; loaded = true; if (store && !name.empty()) put(*store, name); return *this; }
+    config<T>& operator=(const T& v) { value = v; loaded = true; changed(); return *this; }
 
     config(const T& initial) : name(""), store(0), value(initial) {}
 
     config(const std::string& name, const T& initial, nlohmann::json& store = configuration)
-        : name(name), store(&store), value(initial) {}
+        : name(name), store(&store), value(initial) { if (!name.empty()) this->enroll(); }
 
 };
 
@@ -209,7 +387,7 @@ template<typename T> void config<T>::show(HWND w, const T& v) {
 
 // Definition of config_history, std::wstring with history / combobox
 
-struct config_history {
+struct config_history : ConfigRegistered<config_history> {
 
     std::string name;
     nlohmann::json* store;
@@ -234,12 +412,14 @@ struct config_history {
     std::wstring& get(const nlohmann::json& j, std::string_view n) { loaded |= peek(history, j, n); return value(); }
     std::wstring& get(HWND w);
     std::wstring& get(HWND w, int id) { return get(GetDlgItem(w, id)); }
-    std::wstring& get()               { if (!loaded && store && !name.empty()) { get(*store, name); loaded = true; } return value(); }
+    std::wstring& get()               { if (!loaded && store && !name.empty()) { get(ConfigurationLoad::wait(*store), name); loaded = true; } return value(); }
 
     const std::wstring& put(nlohmann::json& j, std::string_view n) const;
     const std::wstring& put(HWND w);
     const std::wstring& put(HWND w, int id)    { return put(GetDlgItem(w, id)); }
 
+    void save() { if (loaded && store && !name.empty()) put(*store, name); }  // called by ConfigRegistry::store
+
     operator std::wstring&() { return get(); }
     config_history& operator=(const std::vector<std::wstring>& v);
     config_history& operator=(const std::wstring& v);
@@ -256,7 +436,9 @@ struct config_history {
     config_history(const std::string& name, const std::vector<std::wstring>& initial = {},
                    int depth = 10, int retain = 0, nlohmann::json& store = configuration)
         : name(name), store(&store), history(initial), depth(std::max(0, depth)),
-          retainBlank(retain & Blank), retainDuplicate(retain & Duplicate), retainEmpty(retain & Empty) {}
+          retainBlank(retain & Blank), retainDuplicate(retain & Duplicate), retainEmpty(retain & Empty) {
+        if (!name.empty()) enroll();
+    }
 
 };
 
@@ -321,17 +503,17 @@ inline std::wstring& config_history::get(HWND w) {
         else history.push_back(itemText);
     }
     loaded = true;
-    if (store && !name.empty()) put(*store, name);
+    changed();
     return history[0];
 }
 
 inline const std::wstring& config_history::put(nlohmann::json& j, std::string_view n) const {
     static const std::wstring empty;
     if (history.empty()) {
-        j[n] = { "" };
+        ConfigurationChange::store(j, n, nlohmann::json::array({ "" }));
         return empty;
     }
-    j[n] = history;
+    ConfigurationChange::store(j, n, history);
     return history[0];
 }
 
@@ -355,7 +537,7 @@ inline const std::wstring& config_history::put(HWND w) {
 inline config_history& config_history::operator=(const std::vector<std::wstring>& v) {
     history = v;
     loaded = true;
-    if (store && !name.empty()) put(*store, name);
+    changed();
     return *this;
 }
 
@@ -363,7 +545,7 @@ inline config_history& config_history::operator=(const std::wstring& v) {
     if (history.empty()) history.push_back(v);
     else                 history[0] = v;
     loaded = true;
-    if (store && !name.empty()) put(*store, name);
+    changed();
     return *this;
 }
 
@@ -388,14 +570,14 @@ inline config_history& config_history::operator+=(const std::wstring& v) {
     }
     if (depth && static_cast<int>(history.size()) > depth) history.resize(depth);
     loaded = true;
-    if (store && !name.empty()) put(*store, name);
+    changed();
     return *this;
 }
 
 
 // Definition of config_rect, for saving and restoring dialog or other top-level window positions
 
-struct config_rect {
+struct config_rect : ConfigRegistered<config_rect> {
 
     std::string name;
     nlohmann::json* store;
@@ -411,17 +593,21 @@ struct config_rect {
     static void show(HWND w, const RECT& v = RECT());
 
     RECT& get(const nlohmann::json& j, std::string_view n) { loaded |= peek(value, j, n); return value; }
-    RECT& get(HWND w) { if (peek(value, w)) { loaded = true; if (store && !name.empty()) put(*store, name); } return value; }
-    RECT& get()       { if (!loaded && store && !name.empty()) { get(*store, name); loaded = true; } return value; }
+    RECT& get(HWND w) { if (peek(value, w)) { loaded = true; changed(); } return value; }
+    RECT& get()       { if (!loaded && store && !name.empty()) { get(ConfigurationLoad::wait(*store), name); loaded = true; } return value; }
 
     const RECT& put(nlohmann::json& j, std::string_view n) const;
     const RECT& put(HWND w) { show(w, get()); return value; }
 
+    void save() { if (loaded && store && !name.empty()) put(*store, name); }  // called by ConfigRegistry::store
+
     operator RECT& () { return get(); }
-    config_rect& operator=(const RECT& v) { value = v; loaded = true; if (store && !name.empty()) put(*store, name); return *this; }
+    config_rect& operator=(const RECT& v) { value = v; loaded = true; changed(); return *this; }
 
     config_rect() : name(""), store(0) {}
-    config_rect(const std::string& name, nlohmann::json& store = configuration) : name(name), store(&store) {}
+    config_rect(const std::string& name, nlohmann::json& store = configuration) : name(name), store(&store) {
+        if (!name.empty()) enroll();
+    }
 
 };
 
@@ -488,6 +674,6 @@ inline void config_rect::show(HWND w, const RECT& v) {
 }
 
 inline const RECT& config_rect::put(nlohmann::json& j, std::string_view n) const {
-    j[n] = nlohmann::json::array({ value.left, value.top, value.right, value.bottom });
+    ConfigurationChange::store(j, n, nlohmann::json::array({ value.left, value.top, value.right, value.bottom }));
     return value;
 }
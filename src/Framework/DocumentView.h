@@ -0,0 +1,132 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// DocumentView provides read-only access to the text of a Scintilla document as std::string_view pieces,
+// without copying it.  It uses RangePointer and CharacterPointer, which return pointers into Scintilla's own
+// buffer.  That buffer has a gap at the point of the most recent edit; text before the gap and text after the gap
+// are each contiguous.  parts(), chunks() and window() never move the gap unless asked for a single view of text
+// which spans it, so scanning a document with them costs no allocation and no copying.
+//
+// Pointers into the buffer remain valid only until the document is changed.  beNotified calls
+// DocumentView::modified() for every SCN_MODIFIED notification (even when notifications are being bypassed)
+// and every buffer activation; after that, valid() returns false, all accessors return empty views and
+// refresh() must be called to use the view again.  Views previously returned must not be used after that.
+// window() and contiguous() may move the gap; when they do, they call modified() themselves, so every other
+// DocumentView becomes invalid too, and views previously returned by any DocumentView must not be used.
+//
+// DocumentView depends only on the ScintillaCall interface, so it can be used with any FunctionDirect,
+// including a stand-in which simulates a document for testing.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "ScintillaCallEx.h"
+
+
+class DocumentView {
+
+    Scintilla::ScintillaCall sci;
+    uint64_t                 generation = 0;
+    Scintilla::Position      total      = 0;
+    Scintilla::Position      gap        = 0;
+    const char*              before     = 0;  // text from 0 to gap
+    const char*              after      = 0;  // text from gap to total
+
+    static inline uint64_t changes = 1;
+
+    void acquire() {
+        generation = changes;
+        total      = sci.Length();
+        gap        = std::clamp<Scintilla::Position>(sci.GapPosition(), 0, total);
+        before     = static_cast<const char*>(sci.RangePointer(0, gap));
+        after      = static_cast<const char*>(sci.RangePointer(gap, total - gap));
+    }
+
+public:
+
+    DocumentView(Scintilla::FunctionDirect fn, intptr_t ptr) {
+        sci.SetFnPtr(fn, ptr);
+        acquire();
+    }
+
+    static void modified() noexcept { ++changes; }
+
+    bool valid() const noexcept { return generation == changes; }
+    void refresh() { acquire(); }
+
+    Scintilla::Position length() const noexcept { return valid() ? total : 0; }
+
+    // The text before and after the gap; either may be empty
+
+    std::string_view part1() const noexcept { return valid() ? std::string_view(before, gap        ) : std::string_view(); }
+    std::string_view part2() const noexcept { return valid() ? std::string_view(after , total - gap) : std::string_view(); }
+
+    // Calls f(position, text) for consecutive pieces of the range start to end, each at most size bytes long;
+    // a piece never spans the gap.  If f returns bool, returning false stops the scan.  Returns false if the
+    // scan was stopped or the view is not valid.
+
+    template<typename F> bool chunks(Scintilla::Position start, Scintilla::Position end, F&& f, Scintilla::Position size = 1 << 20) const {
+        if (!valid()) return false;
+        start = std::clamp<Scintilla::Position>(start, 0, total);
+        end   = std::clamp<Scintilla::Position>(end, start, total);
+        while (start < end) {
+            Scintilla::Position limit = start < gap ? std::min(end, gap) : end;
+            Scintilla::Position n     = std::min(limit - start, size);
+            const char* p = start < gap ? before + start : after + (start - gap);
+            if constexpr (std::is_same_v<decltype(f(start, std::string_view())), bool>) {
+                if (!f(start, std::string_view(p, n))) return false;
+            }
+            else f(start, std::string_view(p, n));
+            start += n;
+        }
+        return true;
+    }
+
+    // A single view of the text from start to start + length; if the range spans the gap, Scintilla moves the gap
+
+    std::string_view window(Scintilla::Position start, Scintilla::Position length) {
+        if (!valid()) return std::string_view();
+        start  = std::clamp<Scintilla::Position>(start, 0, total);
+        length = std::clamp<Scintilla::Position>(length, 0, total - start);
+        if (start + length <= gap) return std::string_view(before + start, length);
+        if (start >= gap)          return std::string_view(after + (start - gap), length);
+        const char* p = static_cast<const char*>(sci.RangePointer(start, length));
+        modified();  // the gap moved, so other views' pointers are stale
+        acquire();
+        return std::string_view(p, length);
+    }
+
+    // The whole document as a single view; Scintilla moves the gap to the end of the document
+
+    std::string_view contiguous() {
+        if (!valid()) return std::string_view();
+        if (gap < total) {
+            sci.CharacterPointer();
+            modified();  // the gap moved, so other views' pointers are stale
+            acquire();
+        }
+        return std::string_view(before, total);
+    }
+
+};
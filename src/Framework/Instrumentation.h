@@ -0,0 +1,336 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Instrumentation measures how long menu commands, notification handlers and Scintilla messages take, so that the
+// paths which make Notepad++ stutter can be found.  It is off by default; when Instrumentation::enabled is false,
+// the cost is one test of a flag for each command and notification, and none for Scintilla messages, because the
+// timing trampoline is installed only while instrumentation or tracing is on (by plugin.getScintillaPointers, which
+// is called before each command and each notification handler that uses Scintilla).
+//
+// Each event (a kind and an identifier: the command routine, the notification code or the message number) has a
+// histogram with a bucket for each power of two of QueryPerformanceCounter ticks, from which snapshot estimates
+// the median and 99th percentile.  Histograms are kept in a fixed open-addressed table of atomic counters, so events
+// can be recorded from any thread without locks; when the table is full, new events are not recorded.
+//
+// Trace records a timeline of the same events, plus configuration loading and saving and tasks run by taskPool, for
+// viewing in chrome://tracing or https://ui.perfetto.dev.  While Trace::start has been called and Trace::stop has not,
+// each event's start and end times are written to a ring buffer, which holds the most recent Trace::capacity events;
+// Trace::write streams them to a file in Chrome trace event JSON format.  Recording claims a slot with one atomic
+// increment and publishes it with a sequence number, so it is lock-free; write skips slots being overwritten.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <vector>
+#define NOMINMAX
+#include <windows.h>
+#include "ScintillaCallEx.h"
+
+
+class Instrumentation {
+
+public:
+
+    enum class Kind : uint8_t { Command = 1, NotepadNotification, ScintillaNotification, ScintillaMessage, Configuration, Task };
+
+    struct Summary {
+        Kind        kind;
+        uint64_t    id;
+        const char* name;   // if the event was named (as by the second argument to plugin.cmd); otherwise null
+        uint64_t    count;
+        double      p50;    // all times are in microseconds
+        double      p99;
+        double      max;
+        double      total;
+    };
+
+    static inline std::atomic<bool> enabled = false;
+
+    static const char* kindName(Kind kind) {
+        switch (kind) {
+        case Kind::Command              : return "command";
+        case Kind::NotepadNotification  : return "Notepad++ notification";
+        case Kind::ScintillaNotification: return "Scintilla notification";
+        case Kind::ScintillaMessage     : return "Scintilla message";
+        case Kind::Configuration        : return "configuration";
+        case Kind::Task                 : return "task";
+        }
+        return "unknown";
+    }
+
+    static bool on() { return enabled.load(std::memory_order_relaxed); }
+
+    static int64_t now() {
+        LARGE_INTEGER t;
+        QueryPerformanceCounter(&t);
+        return t.QuadPart;
+    }
+
+    static void record(Kind kind, uint64_t id, int64_t ticks, const char* name = 0) {
+        Entry* entry = find(static_cast<uint64_t>(kind) << 56 ^ id);
+        if (!entry) return;
+        if (name) entry->name.store(name, std::memory_order_relaxed);
+        const uint64_t t = static_cast<uint64_t>(std::max<int64_t>(ticks, 0));
+        entry->count.fetch_add(1, std::memory_order_relaxed);
+        entry->total.fetch_add(t, std::memory_order_relaxed);
+        entry->buckets[std::bit_width(t)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t max = entry->max.load(std::memory_order_relaxed);
+        while (t > max && !entry->max.compare_exchange_weak(max, t, std::memory_order_relaxed));
+    }
+
+    // Times its own lifetime, if instrumentation or tracing was on when it was constructed
+
+    class Scope {
+        Kind        kind;
+        uint64_t    id;
+        const char* name;
+        int64_t     start;
+    public:
+        Scope(Kind kind, uint64_t id, const char* name = 0);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // Returns the function ScintillaCall should use in place of the given direct function
+
+    static Scintilla::FunctionDirect direct(Scintilla::FunctionDirect function);
+
+    // Runs a task for taskPool (see TaskPool::setRunner), timing it
+
+    static void runTask(std::function<void()>& task) {
+        Scope timing(Kind::Task, 0, "task");
+        task();
+    }
+
+    static std::vector<Summary> snapshot() {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        const double microseconds = 1e6 / static_cast<double>(frequency.QuadPart);
+        std::vector<Summary> result;
+        for (const Entry& entry : table) {
+            uint64_t key   = entry.key.load(std::memory_order_acquire);
+            uint64_t count = entry.count.load(std::memory_order_relaxed);
+            if (!key || !count) continue;
+            uint64_t buckets[65];
+            for (size_t b = 0; b < 65; ++b) buckets[b] = entry.buckets[b].load(std::memory_order_relaxed);
+            const uint64_t max = entry.max.load(std::memory_order_relaxed);
+            auto percentile = [&](double q) {  // upper bound of the bucket containing the q quantile, but not above max
+                uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(count) + 0.5));
+                uint64_t seen   = 0;
+                for (size_t b = 0; b < 65; ++b) if ((seen += buckets[b]) >= target) {
+                    uint64_t upper = b == 0 ? 0 : b >= 64 ? UINT64_MAX : (uint64_t(1) << b) - 1;
+                    return static_cast<double>(std::min(upper, max)) * microseconds;
+                }
+                return static_cast<double>(max) * microseconds;
+            };
+            result.push_back({ static_cast<Kind>(key >> 56), key & ((uint64_t(1) << 56) - 1),
+                               entry.name.load(std::memory_order_relaxed), count, percentile(0.5), percentile(0.99),
+                               static_cast<double>(max) * microseconds,
+                               static_cast<double>(entry.total.load(std::memory_order_relaxed)) * microseconds });
+        }
+        return result;
+    }
+
+    // Clears the counts; events already seen keep their places in the table
+
+    static void reset() {
+        for (Entry& entry : table) {
+            entry.count = entry.total = entry.max = 0;
+            for (auto& bucket : entry.buckets) bucket = 0;
+        }
+    }
+
+private:
+
+    struct Entry {  // std::atomic is zero-initialized by its default constructor
+        std::atomic<uint64_t>    key;          // kind << 56 ^ id; 0 while the entry is unused
+        std::atomic<const char*> name;
+        std::atomic<uint64_t>    count;
+        std::atomic<uint64_t>    total;
+        std::atomic<uint64_t>    max;
+        std::atomic<uint64_t>    buckets[65];  // bucket b counts times of bit_width b ticks
+    };
+
+    static constexpr size_t tableSize = 512;  // a power of two
+    static inline Entry table[tableSize];
+
+    static Entry* find(uint64_t key) {
+        size_t index = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 40) & (tableSize - 1);
+        for (size_t probe = 0; probe < tableSize; ++probe, index = (index + 1) & (tableSize - 1)) {
+            uint64_t found = table[index].key.load(std::memory_order_acquire);
+            if (found == key) return &table[index];
+            if (found == 0) {
+                if (table[index].key.compare_exchange_strong(found, key, std::memory_order_acq_rel)) return &table[index];
+                if (found == key) return &table[index];
+            }
+        }
+        return 0;
+    }
+
+    static inline Scintilla::FunctionDirect realDirect = 0;
+
+    static intptr_t timedDirect(intptr_t ptr, unsigned int message, uintptr_t wParam, intptr_t lParam, int* status) {
+        Scope timing(Kind::ScintillaMessage, message);
+        return realDirect(ptr, message, wParam, lParam, status);
+    }
+
+};
+
+
+class Trace {
+
+public:
+
+    static constexpr size_t capacity = 1 << 16;  // a power of two
+
+    static bool on() { return capturing.load(std::memory_order_acquire); }
+
+    // Discards events recorded earlier and starts recording; call only from the main thread
+
+    static void start() {
+        if (!events) events = std::make_unique<Event[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i) events[i].sequence.store(0, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        capturing.store(true, std::memory_order_release);
+    }
+
+    static void stop() { capturing.store(false, std::memory_order_release); }
+
+    static void record(Instrumentation::Kind kind, uint64_t id, const char* name, int64_t start, int64_t end) {
+        if (!on()) return;
+        const uint64_t n = head.fetch_add(1, std::memory_order_relaxed);
+        Event& e = events[n & (capacity - 1)];
+        e.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        e.kind  .store(kind , std::memory_order_relaxed);
+        e.id    .store(id   , std::memory_order_relaxed);
+        e.name  .store(name , std::memory_order_relaxed);
+        e.start .store(start, std::memory_order_relaxed);
+        e.end   .store(end  , std::memory_order_relaxed);
+        e.thread.store(GetCurrentThreadId(), std::memory_order_relaxed);
+        e.sequence.store(n + 1, std::memory_order_release);
+    }
+
+    // Writes the recorded events as Chrome trace event JSON
+
+    static void write(std::ostream& out) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        const double   microseconds = 1e6 / static_cast<double>(frequency.QuadPart);
+        const uint64_t last         = head.load(std::memory_order_acquire);
+        const uint64_t first        = last > capacity ? last - capacity : 0;
+        const DWORD    process      = GetCurrentProcessId();
+        int64_t        origin       = INT64_MAX;
+        std::vector<Copy> copies;
+        copies.reserve(static_cast<size_t>(last - first));
+        for (uint64_t n = first; events && n < last; ++n) {
+            const Event& e = events[n & (capacity - 1)];
+            Copy c;
+            const uint64_t sequence = e.sequence.load(std::memory_order_acquire);
+            c.kind   = e.kind  .load(std::memory_order_relaxed);
+            c.id     = e.id    .load(std::memory_order_relaxed);
+            c.name   = e.name  .load(std::memory_order_relaxed);
+            c.start  = e.start .load(std::memory_order_relaxed);
+            c.end    = e.end   .load(std::memory_order_relaxed);
+            c.thread = e.thread.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence != n + 1 || e.sequence.load(std::memory_order_relaxed) != sequence) continue;
+            copies.push_back(c);
+            origin = std::min(origin, c.start);
+        }
+        const std::ios_base::fmtflags flags     = out.flags();
+        const std::streamsize         precision = out.precision();
+        out << std::fixed << std::setprecision(3);  // nanosecond resolution, however long the capture
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        const char* separator = "\n";
+        for (const Copy& c : copies) {
+            out << separator << "{\"ph\":\"X\",\"cat\":\"" << Instrumentation::kindName(c.kind) << "\",\"name\":\"";
+            if (c.name) writeEscaped(out, c.name);
+            else out << Instrumentation::kindName(c.kind) << ' ' << c.id;
+            out << "\",\"ts\":" << static_cast<double>(c.start - origin) * microseconds
+                << ",\"dur\":" << static_cast<double>(c.end - c.start) * microseconds
+                << ",\"pid\":" << process << ",\"tid\":" << c.thread << '}';
+            separator = ",\n";
+        }
+        out << "\n]}\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+private:
+
+    struct Event {  // std::atomic is zero-initialized by its default constructor
+        std::atomic<uint64_t>              sequence;  // index + 1 once the event is complete; 0 while being written
+        std::atomic<Instrumentation::Kind> kind;
+        std::atomic<uint64_t>              id;
+        std::atomic<const char*>           name;
+        std::atomic<int64_t>               start;
+        std::atomic<int64_t>               end;
+        std::atomic<DWORD>                 thread;
+    };
+
+    struct Copy {
+        Instrumentation::Kind kind;
+        uint64_t              id;
+        const char*           name;
+        int64_t               start;
+        int64_t               end;
+        DWORD                 thread;
+    };
+
+    static inline std::unique_ptr<Event[]> events;
+    static inline std::atomic<uint64_t>    head      = 0;
+    static inline std::atomic<bool>        capturing = false;
+
+    static void writeEscaped(std::ostream& out, const char* s) {
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') out << '\\' << *s;
+            else if (static_cast<unsigned char>(*s) < 0x20) out << ' ';
+            else out << *s;
+        }
+    }
+
+};
+
+
+inline Instrumentation::Scope::Scope(Kind kind, uint64_t id, const char* name)
+    : kind(kind), id(id), name(name), start(on() || Trace::on() ? now() : -1) {}
+
+inline Instrumentation::Scope::~Scope() {
+    if (start < 0) return;
+    const int64_t end = now();
+    if (on()) record(kind, id, end - start, name);
+    Trace::record(kind, id, name, start, end);
+}
+
+inline Scintilla::FunctionDirect Instrumentation::direct(Scintilla::FunctionDirect function) {
+    if (!on() && !Trace::on()) return function;
+    realDirect = function;
+    return timedDirect;
+}
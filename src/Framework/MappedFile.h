@@ -0,0 +1,152 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// MappedFile maps a file into memory, read-only, so it can be parsed in place: there is no stream to read through
+// and no copy of the contents.  Construct it with a path and test it like a stream (a file which can't be opened or
+// mapped tests false); begin() and end() are char pointers delimiting the contents, suitable for the iterator-pair
+// forms of nlohmann::json::parse and from_cbor, and view() returns them as a std::string_view.  An empty file maps
+// successfully, to an empty range.  The mapping is released when the MappedFile is destroyed or closed.
+//
+// The file is opened with full sharing, so others can still write, rename or delete it while it is mapped; however,
+// if another process truncates the file while it is being read, the read faults.  Keep the mapping only as long as it
+// takes to parse the contents.
+//
+// On Windows this uses CreateFileMapping and MapViewOfFile; elsewhere it uses POSIX mmap.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+class MappedFile {
+
+public:
+
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept : start(std::exchange(other.start, nullptr)),
+                                             length(std::exchange(other.length, 0)),
+                                             mapped(std::exchange(other.mapped, false)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            start  = std::exchange(other.start, nullptr);
+            length = std::exchange(other.length, 0);
+            mapped = std::exchange(other.mapped, false);
+        }
+        return *this;
+    }
+
+    explicit operator bool() const { return mapped; }
+
+    const char*      data()  const { return mapped ? start : ""; }
+    size_t           size()  const { return length; }
+    const char*      begin() const { return data(); }
+    const char*      end()   const { return data() + length; }
+    std::string_view view()  const { return std::string_view(data(), length); }
+
+    bool open(const std::filesystem::path& path) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX) {
+            CloseHandle(file);
+            return false;
+        }
+        if (fileSize.QuadPart) {  // a file mapping of an empty file can't be created
+            HANDLE mapping = CreateFileMapping(file, 0, PAGE_READONLY, 0, 0, 0);
+            if (mapping) {
+                start = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);  // the view keeps the mapping open
+            }
+            if (!start) {
+                CloseHandle(file);
+                return false;
+            }
+        }
+        CloseHandle(file);
+        length = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0) return false;
+        struct stat status;
+        if (fstat(file, &status) || static_cast<uint64_t>(status.st_size) > SIZE_MAX) {
+            ::close(file);
+            return false;
+        }
+        if (status.st_size) {
+            void* view = mmap(0, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (view == MAP_FAILED) {
+                ::close(file);
+                return false;
+            }
+            madvise(view, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+            start = static_cast<const char*>(view);
+        }
+        ::close(file);  // the mapping keeps the file open
+        length = static_cast<size_t>(status.st_size);
+#endif
+        mapped = true;
+        return true;
+    }
+
+    void close() {
+        if (start) {
+#ifdef _WIN32
+            UnmapViewOfFile(start);
+#else
+            munmap(const_cast<char*>(start), length);
+#endif
+        }
+        start  = nullptr;
+        length = 0;
+        mapped = false;
+    }
+
+private:
+
+    const char* start  = nullptr;  // null if not mapped, or if the file is empty
+    size_t      length = 0;
+    bool        mapped = false;
+
+};
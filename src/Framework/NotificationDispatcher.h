@@ -0,0 +1,175 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// NotificationDispatcher routes notifications from Notepad++ and Scintilla to handlers listed in a table, in the
+// same way that menuDefinition lists the functions that process menu commands.  Each entry names a notification
+// code, a handler and, optionally, conditions under which the handler is not called:
+//
+//     NotificationHandler notificationDefinition[] = {
+//         { NPPN_FILEOPENED                  , fileOpened                                            },
+//         { NPPN_FILECLOSED                  , fileClosed , notDuringStartupOrShutdown                },
+//         { Scintilla::Notification::Modified, scnModified, setScintillaPointers, SC_MOD_INSERTTEXT },
+//     };
+//     NotificationDispatcher notifications(notificationDefinition);
+//
+// and beNotified calls notifications.dispatch.  Handlers for Notepad++ notifications take a const NMHDR*; handlers
+// for Scintilla notifications take a const Scintilla::NotificationData*.  For Scintilla::Notification::Modified,
+// the last value is a mask of modification flags: the handler is called only if the notification has at least one
+// of them (0 means any).  modificationFlags() returns the union of the masks, for NPPM_ADDSCNMODIFIEDFLAGS.  When
+// there is more than one handler for a code, they are called in the order listed.
+//
+// The handlers for each code are found by indexing a flat array, so a notification with no handlers returns at once,
+// without setting plugin.bypassNotifications or looking up Scintilla pointers.  (NPPN_GLOBALMODIFIED is recognized
+// by its code, since Notepad++ sends the buffer id in place of its window handle.)  While handlers run, notifications
+// are bypassed, as before.  For profiling, the dispatcher counts the notifications received for each code (whether
+// or not they are handled) and accumulates the time spent in its handlers; report lists codes that were received.
+// When Instrumentation or Trace is on, the time for each notification is also recorded there.
+// The dispatcher must be used only from the thread that runs the Notepad++ message loop.
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include "PluginFramework.h"
+
+
+enum NotificationFilter : unsigned int {
+    notDuringStartupOrShutdown = 1,  // skip while plugin.startupOrShutdown is true
+    notWhileFileIsOpening      = 2,  // skip while plugin.fileIsOpening is true
+    setScintillaPointers       = 4,  // call plugin.getScintillaPointers (for the source Scintilla, if there is one) first
+};
+
+
+struct NotificationHandler {
+
+    using NppHandler = void(*)(const NMHDR*);
+    using ScnHandler = void(*)(const Scintilla::NotificationData*);
+
+    unsigned int         code;
+    NppHandler           npp        = 0;
+    ScnHandler           scn        = 0;
+    unsigned int         filter     = 0;
+    int                  modifyMask = 0;
+    NotificationHandler* next       = 0;  // set by the dispatcher
+
+    NotificationHandler(unsigned int code, NppHandler handler, unsigned int filter = 0)
+        : code(code), npp(handler), filter(filter) {}
+
+    NotificationHandler(Scintilla::Notification code, ScnHandler handler, unsigned int filter = 0, int modifyMask = 0)
+        : code(static_cast<unsigned int>(code)), scn(handler), filter(filter), modifyMask(modifyMask) {}
+
+};
+
+
+class NotificationDispatcher {
+
+    static constexpr unsigned int nppFirst = NPPN_FIRST;
+    static constexpr unsigned int scnFirst = static_cast<unsigned int>(Scintilla::Notification::StyleNeeded);
+
+    struct Slot {
+        NotificationHandler* first = 0;
+        NotificationHandler* last  = 0;
+        uint64_t             count = 0;
+        int64_t              ticks = 0;
+    };
+
+    Slot nppSlots[64];
+    Slot scnSlots[96];
+    int  modifyFlags = 0;
+
+    Slot* slot(bool scintilla, unsigned int code) {
+        unsigned int index = code - (scintilla ? scnFirst : nppFirst);  // codes below the first wrap to large values
+        if (scintilla) return index < std::size(scnSlots) ? &scnSlots[index] : 0;
+        return index < std::size(nppSlots) ? &nppSlots[index] : 0;
+    }
+
+public:
+
+    template<size_t N> explicit NotificationDispatcher(NotificationHandler (&table)[N]) {
+        for (NotificationHandler& handler : table) {
+            Slot* s = slot(handler.scn != 0, handler.code);
+            if (!s) continue;
+            if (s->last) s->last->next = &handler;
+            else s->first = &handler;
+            s->last = &handler;
+            if (handler.code == static_cast<unsigned int>(Scintilla::Notification::Modified))
+                modifyFlags |= handler.modifyMask ? handler.modifyMask : -1;
+        }
+    }
+
+    int modificationFlags() const { return modifyFlags; }
+
+    void dispatch(const NMHDR* nmhdr) {
+        bool scintilla;
+        if (nmhdr->hwndFrom == plugin.nppData._nppHandle || nmhdr->code == NPPN_GLOBALMODIFIED) scintilla = false;
+        else if (nmhdr->hwndFrom == plugin.nppData._scintillaMainHandle
+              || nmhdr->hwndFrom == plugin.nppData._scintillaSecondHandle) scintilla = true;
+        else return;
+        Slot* s = slot(scintilla, nmhdr->code);
+        if (!s) return;
+        ++s->count;
+        if (!s->first || plugin.bypassNotifications) return;
+        plugin.bypassNotifications = true;
+        LARGE_INTEGER start, stop;
+        QueryPerformanceCounter(&start);
+        auto scnp = reinterpret_cast<const Scintilla::NotificationData*>(nmhdr);
+        for (NotificationHandler* handler = s->first; handler; handler = handler->next) {
+            if ((handler->filter & notDuringStartupOrShutdown) && plugin.startupOrShutdown) continue;
+            if ((handler->filter & notWhileFileIsOpening     ) && plugin.fileIsOpening    ) continue;
+            if (scintilla) {
+                if (handler->modifyMask && !(static_cast<int>(scnp->modificationType) & handler->modifyMask)) continue;
+                if (handler->filter & setScintillaPointers) plugin.getScintillaPointers(scnp);
+                handler->scn(scnp);
+            }
+            else {
+                if (handler->filter & setScintillaPointers) plugin.getScintillaPointers();
+                handler->npp(nmhdr);
+            }
+        }
+        QueryPerformanceCounter(&stop);
+        s->ticks += stop.QuadPart - start.QuadPart;
+        const auto kind = scintilla ? Instrumentation::Kind::ScintillaNotification : Instrumentation::Kind::NotepadNotification;
+        if (Instrumentation::on()) Instrumentation::record(kind, nmhdr->code, stop.QuadPart - start.QuadPart);
+        Trace::record(kind, nmhdr->code, 0, start.QuadPart, stop.QuadPart);
+        plugin.bypassNotifications = false;
+    }
+
+    // Calls report(scintilla, code, count, seconds) for each code received at least once; seconds is the total time
+    // spent in its handlers
+
+    template<typename Report> void report(Report&& report) const {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        auto list = [&](const Slot* slots, size_t n, bool scintilla, unsigned int first) {
+            for (size_t i = 0; i < n; ++i) if (slots[i].count)
+                report(scintilla, first + static_cast<unsigned int>(i), slots[i].count,
+                       static_cast<double>(slots[i].ticks) / static_cast<double>(frequency.QuadPart));
+        };
+        list(nppSlots, std::size(nppSlots), false, nppFirst);
+        list(scnSlots, std::size(scnSlots), true , scnFirst);
+    }
+
+    void resetStatistics() {
+        for (Slot& s : nppSlots) s.count = s.ticks = 0;
+        for (Slot& s : scnSlots) s.count = s.ticks = 0;
+    }
+
+};
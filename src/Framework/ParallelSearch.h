@@ -0,0 +1,189 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// parallelSearch finds all instances of the terms in an AhoCorasick automaton in a range of a text, using the workers
+// of a TaskPool.  The range is divided into chunks which the workers (and the calling thread) take in turn, so a
+// thread which finishes early takes more chunks.  Each chunk is scanned from its start to its end plus the length of
+// the longest term less one (but not past the end of the range), and reports only instances which begin within the
+// chunk; so every instance lying entirely within the range is found exactly once, and instances which extend past
+// the end of the range are not found, just as with a sequential scan of the range.  Instances are returned in order
+// of position (and, for instances at the same position, in the order the automaton reports them).
+//
+// If charClass is not null, it must point to an array of 256 parallelsearch::CharacterClass values giving the class
+// of each byte; then only whole-word instances are found, by the rule Scintilla uses for FindOption::WholeWord: an
+// instance must begin where the class changes to word or punctuation, and end where it changes from word or
+// punctuation, or at the start or end of the text.  So a term which begins or ends with punctuation matches next to
+// a word character, but not next to more punctuation; and a term which begins or ends with a space never matches
+// except at the start or end of the text.  Scintilla classifies whole characters, and in UTF-8 classifies characters
+// outside ASCII by their Unicode category; this classifies bytes, so non-ASCII characters take the class given for
+// the byte next to the boundary.  Scintilla's default gives all bytes from 0x80 up the word class.
+//
+// When there is only one term, a vectorized matcher which compares the first and last bytes of the term with
+// sixteen positions at a time (on x86 and x64) is used instead of the automaton, unless the automaton was built with
+// matchCase false and the term contains an ASCII letter.
+//
+// cancelled is called before each chunk is started; if it returns true, the search stops and parallelSearch returns
+// false.  threads limits the number of threads used (0 for no limit); threads = 1 does the whole search on the
+// calling thread.
+//
+// sequentialSearch finds the same instances with a single pass of the automaton over the range; test\ParallelSearchTest.cpp
+// compares the two on random texts, terms and ranges.
+//
+// This file depends only on the standard library, AhoCorasick.h and TaskPool.h.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "AhoCorasick.h"
+#include "TaskPool.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define PARALLELSEARCH_SSE2
+#endif
+
+
+struct ParallelSearchHit {
+    size_t position;
+    size_t term;
+};
+
+
+namespace parallelsearch {
+
+enum CharacterClass : uint8_t { space, newLine, word, punctuation };  // the values of Scintilla::CharacterClass
+
+// Tells whether text[begin, finish) is a whole word by Scintilla's rule (Document::IsWordAt); always true when
+// charClass is null
+
+inline bool wholeWord(std::string_view text, size_t begin, size_t finish, const uint8_t* charClass) {
+    if (!charClass) return true;
+    auto classAt = [&](size_t p) { return charClass[static_cast<unsigned char>(text[p])]; };
+    auto wordOrPunctuation = [](uint8_t c) { return c == word || c == punctuation; };
+    const bool starts = begin == 0 || (wordOrPunctuation(classAt(begin)) && classAt(begin) != classAt(begin - 1));
+    const bool ends   = finish >= text.length() || (wordOrPunctuation(classAt(finish - 1)) && classAt(finish - 1) != classAt(finish));
+    return starts && ends;
+}
+
+// Calls f(position) for each instance of term beginning in text[start, end); instances may extend past end, but not
+// past the end of text
+
+template<typename F> void findTerm(std::string_view text, size_t start, size_t end, std::string_view term, F&& f) {
+    const size_t m = term.length();
+    if (!m || text.length() < m) return;
+    end = std::min(end, text.length() - m + 1);
+    const char* p = text.data();
+    size_t i = start;
+#ifdef PARALLELSEARCH_SSE2
+    const __m128i first = _mm_set1_epi8(term[0]);
+    const __m128i last  = _mm_set1_epi8(term[m - 1]);
+    for (; i + 16 <= end; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + m - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask) {
+            unsigned bit = static_cast<unsigned>(std::countr_zero(mask));
+            mask &= mask - 1;
+            if (m <= 2 || !std::memcmp(p + i + bit + 1, term.data() + 1, m - 2)) f(i + bit);
+        }
+    }
+#endif
+    while (i < end) {
+        const void* q = std::memchr(p + i, term[0], end - i);
+        if (!q) break;
+        i = static_cast<size_t>(static_cast<const char*>(q) - p);
+        if (!std::memcmp(p + i, term.data(), m)) f(i);
+        ++i;
+    }
+}
+
+// Finds instances beginning in text[start, end) and ending at or before limit, and appends them to hits, in order of
+// position; text beyond limit is used only to check word boundaries
+
+inline void findChunk(std::string_view text, size_t start, size_t end, size_t limit, const AhoCorasick& automaton,
+                      const uint8_t* charClass, std::vector<ParallelSearchHit>& hits) {
+    auto boundary = [&](size_t begin, size_t finish) { return wholeWord(text, begin, finish, charClass); };
+    const size_t first = hits.size();
+    auto letter = [](char c) { c = AhoCorasick::fold(c); return c >= 'a' && c <= 'z'; };
+    if (automaton.terms() == 1 && (automaton.matchCase() || std::none_of(automaton.term(0).begin(), automaton.term(0).end(), letter))) {
+        const std::string& term = automaton.term(0);
+        findTerm(text.substr(0, limit), start, end, term, [&](size_t p) { if (boundary(p, p + term.length())) hits.push_back({ p, 0 }); });
+        return;
+    }
+    const size_t longest = automaton.longest();
+    const size_t stop    = std::min(limit, end + (longest ? longest - 1 : 0));
+    automaton.scan(text.substr(start, stop - start), [&](size_t term, size_t finish) {
+        size_t begin = finish - automaton.termLength(term);
+        if (begin < end && boundary(begin, finish)) hits.push_back({ begin, term });
+    }, AhoCorasick::start, start);
+    std::stable_sort(hits.begin() + first, hits.end(), [](const ParallelSearchHit& a, const ParallelSearchHit& b) { return a.position < b.position; });
+}
+
+}
+
+
+template<typename Cancelled>
+bool parallelSearch(TaskPool& pool, std::string_view text, size_t start, size_t end, const AhoCorasick& automaton,
+                    const uint8_t* charClass, std::vector<ParallelSearchHit>& hits, Cancelled&& cancelled,
+                    unsigned threads = 0, size_t chunk = 1 << 20) {
+    end = std::min(end, text.length());
+    if (start >= end || automaton.empty()) return !cancelled();
+    const size_t chunks = (end - start + chunk - 1) / chunk;
+    std::vector<std::vector<ParallelSearchHit>> found(chunks);
+    std::atomic<bool> stopped = false;
+    pool.forEach(chunks, [&](size_t k) {
+        if (stopped.load(std::memory_order_relaxed)) return;
+        if (cancelled()) {
+            stopped = true;
+            return;
+        }
+        size_t s = start + k * chunk;
+        parallelsearch::findChunk(text, s, std::min(end, s + chunk), end, automaton, charClass, found[k]);
+    }, threads);
+    if (stopped) return false;
+
+    size_t total = hits.size();
+    for (const auto& f : found) total += f.size();
+    hits.reserve(total);
+    for (const auto& f : found) hits.insert(hits.end(), f.begin(), f.end());
+    return true;
+}
+
+
+// Finds the same instances as parallelSearch, on the calling thread, with a single pass of the automaton
+
+inline void sequentialSearch(std::string_view text, size_t start, size_t end, const AhoCorasick& automaton,
+                             const uint8_t* charClass, std::vector<ParallelSearchHit>& hits) {
+    end = std::min(end, text.length());
+    if (start >= end || automaton.empty()) return;
+    const size_t first = hits.size();
+    automaton.scan(text.substr(start, end - start), [&](size_t term, size_t finish) {
+        size_t begin = finish - automaton.termLength(term);
+        if (parallelsearch::wholeWord(text, begin, finish, charClass)) hits.push_back({ begin, term });
+    }, AhoCorasick::start, start);
+    std::stable_sort(hits.begin() + first, hits.end(), [](const ParallelSearchHit& a, const ParallelSearchHit& b) { return a.position < b.position; });
+}
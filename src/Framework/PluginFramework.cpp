@@ -15,6 +15,7 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "PluginFramework.h"
+#include "TaskPool.h"
 
 PluginData plugin;
 
@@ -31,6 +32,7 @@ BOOL APIENTRY DllMain(HINSTANCE instance, DWORD reasonForCall, LPVOID) {
                 break;
 
             case DLL_PROCESS_DETACH:
+                taskPool.abandon();  // normally the pool was shut down at NPPN_SHUTDOWN, and this does nothing
                 break;
 
             case DLL_THREAD_ATTACH:
@@ -48,6 +50,8 @@ extern "C" __declspec(dllexport) void setInfo(NPP::NppData nppData) {
     plugin.nppData = nppData;
     plugin.directStatusScintilla = reinterpret_cast<Scintilla::FunctionDirect>
         (SendMessage(plugin.nppData._scintillaMainHandle, static_cast<UINT>(Scintilla::Message::GetDirectStatusFunction), 0, 0));
+    createUiWindow(plugin.dllInstance);
+    taskPool.setRunner(Instrumentation::runTask);
 }
 
 extern "C" __declspec(dllexport) BOOL isUnicode() {return TRUE;}
@@ -25,6 +25,7 @@
 #include <windows.h>
 #include <commctrl.h>
 
+#include "Instrumentation.h"
 #include "ScintillaCallEx.h"
 
 namespace NPP {
@@ -47,10 +48,31 @@ struct PluginData {
     bool                      fileIsOpening       = false; // A new file is opening
     bool                      startupOrShutdown   = true;  // Notepad++ is starting up or shutting down
 
-    HWND currentScintilla() const {
-        int currentEdit = 0;
-        SendMessage(nppData._nppHandle, NPPM_GETCURRENTSCINTILLA, 0, reinterpret_cast<LPARAM>(&currentEdit));
-        return currentEdit ? nppData._scintillaSecondHandle : nppData._scintillaMainHandle;
+    // Scintilla direct pointers never change during the life of a Scintilla window, so they are requested only once
+    // for each of the two edit windows.  The current view is requested only when needed after it might have changed:
+    // beNotified calls forgetCurrentScintilla on NPPN_READY and NPPN_BUFFERACTIVATED, even when bypassing notifications.
+    // The counters show how many SendMessage round trips were made and how many the caching avoided.
+
+    intptr_t pointerMain   = 0;
+    intptr_t pointerSecond = 0;
+    int      currentView   = -1;
+
+    struct {
+        uint64_t sent  = 0;  // SendMessage calls made for NPPM_GETCURRENTSCINTILLA or SCI_GETDIRECTPOINTER
+        uint64_t saved = 0;  // requests for the current view or a direct pointer satisfied from the cache
+    } scintillaQueries;
+
+    void forgetCurrentScintilla() { currentView = -1; }
+
+    HWND currentScintilla() {
+        if (currentView < 0) {
+            int currentEdit = 0;
+            SendMessage(nppData._nppHandle, NPPM_GETCURRENTSCINTILLA, 0, reinterpret_cast<LPARAM>(&currentEdit));
+            currentView = currentEdit ? 1 : 0;
+            ++scintillaQueries.sent;
+        }
+        else ++scintillaQueries.saved;
+        return currentView ? nppData._scintillaSecondHandle : nppData._scintillaMainHandle;
     }
 
     void getScintillaPointers() {
@@ -62,14 +84,34 @@ struct PluginData {
     }
 
     void getScintillaPointers(HWND scintillaHandle) {
-        pointerScintilla = SendMessage(scintillaHandle, static_cast<UINT>(Scintilla::Message::GetDirectPointer), 0, 0);
-        sci.SetFnPtr(directStatusScintilla, pointerScintilla);
+        intptr_t* cached = scintillaHandle == nppData._scintillaMainHandle   ? &pointerMain
+                         : scintillaHandle == nppData._scintillaSecondHandle ? &pointerSecond
+                                                                             : 0;
+        if (cached && *cached) {
+            pointerScintilla = *cached;
+            ++scintillaQueries.saved;
+        }
+        else {
+            pointerScintilla = SendMessage(scintillaHandle, static_cast<UINT>(Scintilla::Message::GetDirectPointer), 0, 0);
+            if (cached) *cached = pointerScintilla;
+            ++scintillaQueries.sent;
+        }
+        sci.SetFnPtr(Instrumentation::direct(directStatusScintilla), pointerScintilla);  // times messages, if enabled
         sci.SetStatus(Scintilla::Status::Ok);  // C-interface code can ignore an error status, causing exception in C++ interface
     }
 
-    // cmd calls menu commands with notifications bypassed and Scintilla pointers established
+    // send runs a batch of Scintilla messages against the Scintilla control to which sci is directed;
+    // like sci, it throws Scintilla::Failure if a message fails
 
-    void cmd(void (cmdFunction)()) { 
+    void send(Scintilla::ScintillaBatch& batch) {
+        if (!batch.run(directStatusScintilla, pointerScintilla)) throw Scintilla::Failure(batch.status());
+    }
+
+    // cmd calls menu commands with notifications bypassed and Scintilla pointers established;
+    // name identifies the command in Instrumentation reports
+
+    void cmd(void (cmdFunction)(), const char* name = 0) {
+        Instrumentation::Scope timing(Instrumentation::Kind::Command, reinterpret_cast<uintptr_t>(cmdFunction), name);
         bypassNotifications = true;
         getScintillaPointers();
         (cmdFunction)();
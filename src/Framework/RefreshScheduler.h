@@ -0,0 +1,95 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// RefreshScheduler coalesces requests to update user interface elements.  Instead of updating a dialog each time
+// something it displays changes, call RefreshScheduler::request with the address of a void, zero-argument function
+// that does the update.  However many times a function is requested, it is called once, when the user interface
+// thread is next idle and no later than the requested latency (in milliseconds) after the first request.  This keeps
+// operations that generate thousands of notifications (macros, Replace All) from updating dialogs thousands of times.
+//
+// The scheduler uses a thread timer (SetTimer with no window), so it must be used only from the thread that runs the
+// Notepad++ message loop.  Windows posts WM_TIMER only when no other messages are waiting, so refreshes never delay
+// processing of user input.  Call RefreshScheduler::flush to perform pending refreshes immediately, and
+// RefreshScheduler::cancel when the plugin is shutting down (or with a function that no longer needs to be called).
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#define NOMINMAX
+#include <windows.h>
+
+
+class RefreshScheduler {
+
+public:
+
+    using Refresh = void(*)();
+
+    static inline unsigned int defaultLatency = 50;  // milliseconds
+
+    static void request(Refresh refresh) { request(refresh, defaultLatency); }
+
+    static void request(Refresh refresh, unsigned int latency) {
+        if (std::find(pending.begin(), pending.end(), refresh) == pending.end()) pending.push_back(refresh);
+        ULONGLONG due = GetTickCount64() + latency;
+        if (timer && due >= timerDue) return;
+        UINT_PTR id = SetTimer(0, timer, latency, timerProc);  // replaces the existing timer, if there is one
+        if (id) {
+            timer    = id;
+            timerDue = due;
+        }
+        else flush();  // if a timer can't be set, refresh now rather than not at all
+    }
+
+    static void flush() {
+        stopTimer();
+        std::vector<Refresh> due;
+        due.swap(pending);
+        for (Refresh refresh : due) refresh();
+    }
+
+    static void cancel(Refresh refresh) {
+        pending.erase(std::remove(pending.begin(), pending.end(), refresh), pending.end());
+        if (pending.empty()) stopTimer();
+    }
+
+    static void cancel() {
+        pending.clear();
+        stopTimer();
+    }
+
+    static bool isPending(Refresh refresh) { return std::find(pending.begin(), pending.end(), refresh) != pending.end(); }
+
+private:
+
+    static inline std::vector<Refresh> pending;
+    static inline UINT_PTR             timer    = 0;
+    static inline ULONGLONG            timerDue = 0;
+
+    static void stopTimer() {
+        if (timer) KillTimer(0, timer);
+        timer = 0;
+    }
+
+    static void CALLBACK timerProc(HWND, UINT, UINT_PTR, DWORD) { flush(); }
+
+};
@@ -22,6 +22,7 @@
 
 // ScintillaCallEx.cpp and ScintillaCallEx.h patch exceptions raised by the ScintillaCall interface
 // so that they are derived from std::exception, which can improve exception handling in some hosts.
+// ScintillaCallEx.h also defines ScintillaBatch, which sends a sequence of messages with a single error check.
 
 #pragma once
 
@@ -39,6 +40,8 @@
 #undef Failure
 
 #include <charconv>
+#include <cstring>
+#include <vector>
 
 namespace Scintilla {
 
@@ -54,4 +57,73 @@ struct Failure : std::exception {
     }
 };
 
+
+// ScintillaBatch records a sequence of messages, then sends them in a tight loop through a Scintilla direct function.
+// No exception is thrown for a failing message; the batch stops there, and the failure is reported once, by run.
+// Build the batch with add (which can be chained), send it with run, then get return values with result.
+// A batch can be run more than once, and clear empties it while keeping its storage for reuse.
+
+class ScintillaBatch {
+
+    struct Entry {
+        Message   msg;
+        uintptr_t wParam;
+        intptr_t  lParam;
+    };
+
+    std::vector<Entry>    entries;
+    std::vector<intptr_t> results;
+    size_t                failed = npos;
+    Status                failure = Status::Ok;
+
+public:
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    ScintillaBatch& add(Message msg, uintptr_t wParam = 0, intptr_t lParam = 0) {
+        entries.push_back({ msg, wParam, lParam });
+        return *this;
+    }
+
+    ScintillaBatch& add(Message msg, uintptr_t wParam, const void* lParam) {
+        return add(msg, wParam, reinterpret_cast<intptr_t>(lParam));
+    }
+
+    // Sends the messages in order; returns false, having stopped at the first failure, if any message fails
+
+    bool run(FunctionDirect fn, intptr_t ptr) {
+        results.resize(entries.size());
+        failed  = npos;
+        failure = Status::Ok;
+        if (!fn) {
+            failed  = 0;
+            failure = Status::Failure;
+            return false;
+        }
+        for (size_t i = 0; i < entries.size(); ++i) {
+            int status = 0;
+            results[i] = fn(ptr, static_cast<unsigned int>(entries[i].msg), entries[i].wParam, entries[i].lParam, &status);
+            if (status > static_cast<int>(Status::Ok) && status < static_cast<int>(Status::WarnStart)) {
+                failed  = i;
+                failure = static_cast<Status>(status);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    intptr_t result(size_t i) const { return i < results.size() ? results[i] : 0; }
+    size_t   failedAt()       const { return failed; }   // index of the message that failed, or npos
+    Status   status()         const { return failure; }  // status returned by the message that failed, or Status::Ok
+    size_t   size()           const { return entries.size(); }
+
+    void clear() {
+        entries.clear();
+        results.clear();
+        failed  = npos;
+        failure = Status::Ok;
+    }
+
+};
+
 }
@@ -0,0 +1,195 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// This header defines StreamToWide and StreamFromWide, resumable converters between byte strings (in a code page
+// converted by CodePageConversion.h, or UTF-8 processed by UnicodeFormatTranslation.h) and UTF-16.  Input can be supplied in pieces of
+// any size; a character split across pieces (a truncated UTF-8 sequence, a DBCS lead byte or a leading surrogate)
+// is held until the next piece arrives.  Output is delivered to a caller-supplied sink in pieces no larger than
+// the capacity given when the converter is constructed, so arbitrarily long input is processed in fixed memory.
+//
+// Usage:
+//
+//     StreamToWide converter(codepage);
+//     converter.convert(piece1, false, sink);
+//     converter.convert(piece2, false, sink);
+//     ...
+//     converter.convert(pieceN, true , sink);   // or converter.finish(sink) after the last piece
+//
+// where sink is any callable accepting a std::wstring_view (for StreamToWide) or a std::string_view (for
+// StreamFromWide).  The views passed to the sink are valid only until the sink returns.  After the last piece,
+// the converter is reset and can be used again.
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CodePageConversion.h"
+#include "UnicodeFormatTranslation.h"
+
+
+class StreamToWide {
+
+    static constexpr unsigned int UnicodeFormat = static_cast<unsigned int>(-1);
+
+    unsigned int         codepage;
+    InvalidUnicode       errs = InvalidUnicode::Substitute;
+    std::vector<wchar_t> buffer;
+    char                 carry[4];
+    size_t               carried = 0;
+
+    // Length of the longest prefix of p[0 .. n) that can be converted without knowing what follows it
+
+    size_t safeLength(const char* p, size_t n) const {
+        if (codepage == CP_UTF8 || codepage == UnicodeFormat) {
+            for (size_t j = n; j > 0 && j + 3 >= n + 1; --j) {
+                if (utf8byte::isTrail(p[j - 1])) continue;
+                size_t length = utf8byte::implicit_length(p[j - 1]);
+                return j - 1 + length > n ? j - 1 : n;
+            }
+            return n;
+        }
+        size_t leads = 0;
+        while (leads < n && cpconvert::isLeadByte(codepage, p[n - leads - 1])) ++leads;
+        return leads & 1 ? n - 1 : n;
+    }
+
+    // Number of bytes needed to complete the carried partial character
+
+    size_t carryNeeds() const {
+        if (codepage == CP_UTF8 || codepage == UnicodeFormat) return utf8byte::implicit_length(carry[0]) - carried;
+        return 2 - carried;
+    }
+
+    template<typename Sink> void emit(const char* p, size_t n, Sink& sink) {
+        while (n) {
+            size_t k = std::min(n, buffer.size());
+            if (k < n) k = safeLength(p, k);  // don't separate a multibyte character
+            size_t m = 0;
+            if (codepage == UnicodeFormat) m = utf8to16_into(std::string_view(p, k), buffer, errs);
+            else m = cpconvert::toWide(codepage, std::string_view(p, k), buffer.data(), buffer.size());
+            if (m) sink(std::wstring_view(buffer.data(), m));
+            p += k;
+            n -= k;
+        }
+    }
+
+public:
+
+    // Convert from a code page, using cpconvert::toWide
+
+    explicit StreamToWide(unsigned int codepage, size_t capacity = 65536)
+        : codepage(codepage), buffer(std::max<size_t>(capacity, 16)) {}
+
+    // Convert from UTF-8, using utf8to16 with the specified handling of invalid UTF-8
+
+    explicit StreamToWide(InvalidUnicode errs, size_t capacity = 65536)
+        : codepage(UnicodeFormat), errs(errs), buffer(std::max<size_t>(capacity, 16)) {}
+
+    template<typename Sink> void convert(std::string_view input, bool last, Sink&& sink) {
+        const char* p = input.data();
+        size_t      n = input.length();
+        if (carried) {
+            size_t needs = carryNeeds();
+            while (needs && n && ((codepage != CP_UTF8 && codepage != UnicodeFormat) || utf8byte::isTrail(*p))) {
+                carry[carried++] = *p++;
+                --n;
+                --needs;
+            }
+            if (needs && !n && !last) return;
+            emit(carry, carried, sink);
+            carried = 0;
+        }
+        size_t complete = last ? n : safeLength(p, n);
+        emit(p, complete, sink);
+        for (; complete < n; ++complete) carry[carried++] = p[complete];
+    }
+
+    template<typename Sink> void finish(Sink&& sink) { convert(std::string_view(), true, sink); }
+
+    void reset() { carried = 0; }
+
+};
+
+
+class StreamFromWide {
+
+    static constexpr unsigned int UnicodeFormat = static_cast<unsigned int>(-1);
+
+    unsigned int      codepage;
+    InvalidUnicode    errs = InvalidUnicode::Substitute;
+    std::vector<char> buffer;
+    wchar_t           carry = 0;
+    bool              carried = false;
+
+    template<typename Sink> void emit(const wchar_t* p, size_t n, Sink& sink) {
+        const size_t slice = buffer.size() / 4;
+        while (n) {
+            size_t k = std::min(n, slice);
+            if (k < n && p[k - 1] >= 0xD800 && p[k - 1] <= 0xDBFF) --k;  // don't separate a surrogate pair
+            size_t m = 0;
+            if (codepage == UnicodeFormat) m = utf16to8_into(std::wstring_view(p, k), buffer, errs);
+            else m = cpconvert::fromWide(codepage, std::wstring_view(p, k), buffer.data(), buffer.size());
+            if (m) sink(std::string_view(buffer.data(), m));
+            p += k;
+            n -= k;
+        }
+    }
+
+public:
+
+    // Convert to a code page, using cpconvert::fromWide
+
+    explicit StreamFromWide(unsigned int codepage, size_t capacity = 65536)
+        : codepage(codepage), buffer(std::max<size_t>(capacity, 16)) {}
+
+    // Convert to UTF-8, using utf16to8 with the specified handling of invalid UTF-16
+
+    explicit StreamFromWide(InvalidUnicode errs, size_t capacity = 65536)
+        : codepage(UnicodeFormat), errs(errs), buffer(std::max<size_t>(capacity, 16)) {}
+
+    template<typename Sink> void convert(std::wstring_view input, bool last, Sink&& sink) {
+        const wchar_t* p = input.data();
+        size_t         n = input.length();
+        if (carried) {
+            if (!n && !last) return;
+            wchar_t pair[2] = { carry, n ? *p : 0 };
+            bool complete = n && *p >= 0xDC00 && *p <= 0xDFFF;
+            emit(pair, complete ? 2 : 1, sink);
+            if (complete) {
+                ++p;
+                --n;
+            }
+            carried = false;
+        }
+        if (!last && n && p[n - 1] >= 0xD800 && p[n - 1] <= 0xDBFF) {
+            carry = p[--n];
+            carried = true;
+        }
+        emit(p, n, sink);
+    }
+
+    template<typename Sink> void finish(Sink&& sink) { convert(std::wstring_view(), true, sink); }
+
+    void reset() { carried = false; }
+
+};
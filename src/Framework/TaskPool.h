@@ -0,0 +1,280 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// TaskPool runs tasks on a set of worker threads, so that lengthy work need not block the Notepad++ user interface.
+//
+// Each worker has its own double-ended queue.  A task submitted by a worker goes on the back of that worker's queue,
+// and the worker takes tasks from the back of its own queue (so the most recently divided work, whose data is most
+// likely to be in cache, is done first); tasks submitted from other threads go on a shared queue.  A worker with
+// nothing to do takes tasks from the shared queue, or steals from the front of another worker's queue.
+//
+// Workers are started when the first task is submitted.  shutdown() stops them (discarding tasks not yet started)
+// and waits for tasks in progress to finish; after that, submit does nothing and forEach runs on the calling thread.
+// abandon() stops the workers without waiting; use it only when the process is ending.
+//
+// forEach(count, f) calls f(0) through f(count - 1), spreading the calls over the workers and the calling thread,
+// and returns when all calls have finished; if any call throws an exception, forEach rethrows the first one.
+//
+// setRunner(runner) makes workers call runner(task) instead of task(), so that tasks can be timed or traced.
+//
+// postToUi(task) passes a task to the sink given when the pool was constructed, which should arrange for it to run
+// on the user interface thread.  TaskPool itself depends only on the standard library; on Windows, this file also
+// defines the global taskPool, whose sink posts tasks to a message-only window created by createUiWindow (which
+// PluginFramework.cpp calls from setInfo).  For testing, construct a TaskPool with a sink that queues tasks instead.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class TaskPool {
+
+public:
+
+    using Task   = std::function<void()>;
+    using UiSink = std::function<bool(Task&&)>;  // returns false if the task could not be posted
+    using Runner = void(*)(Task&);               // runs a task on a worker; for example, to time it
+
+    explicit TaskPool(unsigned threads = 0, UiSink sink = {}) : requested(threads), sink(std::move(sink)) {}
+    ~TaskPool() { shutdown(); }
+
+    TaskPool(const TaskPool&)            = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    void submit(Task task) {
+        if (!start()) return;
+        Worker* self = current == this ? workers[index].get() : nullptr;
+        ++queued;
+        {
+            std::lock_guard lock(self ? self->mutex : sharedMutex);
+            (self ? self->tasks : shared).push_back(std::move(task));
+        }
+        { std::lock_guard lock(sleepMutex); }
+        wake.notify_one();
+    }
+
+    template<typename F> void forEach(size_t count, F&& f, unsigned maxThreads = 0) {
+        if (!count) return;
+        struct State {
+            std::atomic<size_t>     next     = 0;
+            std::atomic<size_t>     finished = 0;
+            std::mutex              mutex;
+            std::condition_variable done;
+            std::exception_ptr      error;
+        };
+        auto state = std::make_shared<State>();
+        auto body  = [state, count, &f] {
+            for (size_t i; (i = state->next.fetch_add(1)) < count;) {
+                try { f(i); }
+                catch (...) {
+                    std::lock_guard lock(state->mutex);
+                    if (!state->error) state->error = std::current_exception();
+                }
+                if (state->finished.fetch_add(1) + 1 == count) {
+                    std::lock_guard lock(state->mutex);
+                    state->done.notify_all();
+                }
+            }
+        };
+        size_t helpers = count - 1;
+        if (maxThreads) helpers = std::min<size_t>(helpers, maxThreads - 1);
+        if (helpers && start()) {
+            helpers = std::min<size_t>(helpers, workers.size());
+            for (size_t h = 0; h < helpers; ++h) submit(body);
+        }
+        body();
+        std::unique_lock lock(state->mutex);
+        state->done.wait(lock, [&] { return state->finished.load() == count; });
+        if (state->error) std::rethrow_exception(state->error);
+    }
+
+    bool postToUi(Task task) { return sink && sink(std::move(task)); }
+
+    void setRunner(Runner runner) { this->runner.store(runner, std::memory_order_relaxed); }
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    void shutdown() { stop(true); }
+    void abandon()  { stop(false); }
+
+private:
+
+    struct Worker {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+        std::thread      thread;
+    };
+
+    unsigned                             requested;
+    UiSink                               sink;
+    std::atomic<Runner>                  runner = nullptr;
+    std::once_flag                       started;
+    std::atomic<bool>                    stopping = false;
+    bool                                 abandoned = false;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex                           sharedMutex;
+    std::deque<Task>                     shared;
+    std::atomic<size_t>                  queued = 0;
+    std::mutex                           sleepMutex;
+    std::condition_variable              wake;
+
+    static inline thread_local TaskPool* current = nullptr;  // pool of which this thread is a worker
+    static inline thread_local size_t    index   = 0;        // and its index in that pool
+
+    bool start() {
+        std::call_once(started, [this] {
+            if (stopping) return;
+            unsigned n = requested ? requested : std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned i = 0; i < n; ++i) workers.push_back(std::make_unique<Worker>());
+            for (unsigned i = 0; i < n; ++i) workers[i]->thread = std::thread([this, i] { run(i); });
+        });
+        return !stopping && !workers.empty();
+    }
+
+    bool take(size_t self, Task& task) {
+        auto from = [&](std::mutex& mutex, std::deque<Task>& tasks, bool back) {
+            std::lock_guard lock(mutex);
+            if (tasks.empty()) return false;
+            if (back) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+            }
+            else {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            --queued;
+            return true;
+        };
+        if (from(workers[self]->mutex, workers[self]->tasks, true)) return true;
+        if (from(sharedMutex, shared, false)) return true;
+        for (size_t k = 1; k < workers.size(); ++k) {
+            Worker& victim = *workers[(self + k) % workers.size()];
+            if (from(victim.mutex, victim.tasks, false)) return true;
+        }
+        return false;
+    }
+
+    void run(size_t self) {
+        current = this;
+        index   = self;
+        while (!stopping) {
+            Task task;
+            if (take(self, task)) {
+                try {
+                    if (Runner r = runner.load(std::memory_order_relaxed)) r(task);
+                    else task();
+                }
+                catch (...) {}
+                continue;
+            }
+            std::unique_lock lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+        }
+    }
+
+    void stop(bool wait) {
+        if (abandoned) return;
+        std::call_once(started, [] {});  // a pool which never started never will
+        {
+            std::lock_guard lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) if (worker->thread.joinable()) {
+            if (wait && worker->thread.get_id() != std::this_thread::get_id()) worker->thread.join();
+            else worker->thread.detach();
+        }
+        if (!wait) {
+            abandoned = true;
+            return;
+        }
+        for (auto& worker : workers) worker->tasks.clear();
+        shared.clear();
+    }
+
+};
+
+
+#ifdef _WIN32
+
+#define NOMINMAX
+#include <windows.h>
+
+namespace taskpool_ui {
+
+    inline std::atomic<HWND> window = 0;  // tasks may be posted from any thread
+
+    inline LRESULT CALLBACK windowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+        if (uMsg == WM_APP) {
+            std::unique_ptr<TaskPool::Task> task(reinterpret_cast<TaskPool::Task*>(lParam));
+            try { (*task)(); } catch (...) {}
+            return 0;
+        }
+        return DefWindowProc(hwnd, uMsg, wParam, lParam);
+    }
+
+    inline bool post(TaskPool::Task&& task) {
+        HWND w = window.load(std::memory_order_acquire);
+        if (!w) return false;
+        auto* p = new TaskPool::Task(std::move(task));
+        if (PostMessage(w, WM_APP, 0, reinterpret_cast<LPARAM>(p))) return true;
+        delete p;
+        return false;
+    }
+
+}
+
+// Call createUiWindow on the user interface thread before any task is posted; call destroyUiWindow on the same thread
+// after taskPool.shutdown(), and after any other thread which might post a task has finished, to discard tasks posted
+// but not yet run.
+
+inline void createUiWindow(HINSTANCE instance) {
+    if (taskpool_ui::window) return;
+    WNDCLASSEX wc = { sizeof(WNDCLASSEX) };
+    wc.lpfnWndProc   = taskpool_ui::windowProc;
+    wc.hInstance     = instance;
+    wc.lpszClassName = L"TaskPoolUiWindow";
+    RegisterClassEx(&wc);
+    taskpool_ui::window.store(CreateWindowEx(0, wc.lpszClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, 0, instance, 0),
+                              std::memory_order_release);
+}
+
+inline void destroyUiWindow() {
+    HWND window = taskpool_ui::window.exchange(0);  // no more tasks can be posted
+    if (!window) return;
+    MSG msg;
+    while (PeekMessage(&msg, window, WM_APP, WM_APP, PM_REMOVE)) delete reinterpret_cast<TaskPool::Task*>(msg.lParam);
+    DestroyWindow(window);
+}
+
+inline TaskPool taskPool(0, taskpool_ui::post);
+
+#endif
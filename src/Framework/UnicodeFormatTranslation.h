@@ -20,10 +20,26 @@
 // SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 // This header provides inline functions for conversion between between Unicode formats utf-8, utf-16 and utf-32.
-// It also contains inline functions in the utf8byte namespace for interpreting individual bytes in a utf-8 stream.
+// It also contains inline functions in the utf8byte namespace for interpreting individual bytes in a utf-8 stream,
+// and vectorized kernels in the utfsimd namespace which the conversion functions use to process runs of ASCII.
 
 #pragma once
+#include <cstdint>
+#include <cstring>
+#include <span>
 #include <string>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#    define UTFSIMD_X86 1
+#    include <immintrin.h>
+#    if defined(_MSC_VER) && !defined(__clang__)
+#        include <intrin.h>
+#        define UTFSIMD_AVX2
+#    else
+#        define UTFSIMD_AVX2 __attribute__((target("avx2")))
+#    endif
+#endif
 
 enum class InvalidUnicode {
     Substitute  = 0,  // Use substitution character when transcoding invalid Unicode
@@ -57,151 +73,539 @@ namespace utf8byte {
 }
 
 
+// Vectorized kernels for runs of ASCII code units
+//
+// ascii(p, n) returns the number of leading code units in p[0 .. n) which are ASCII (less than 0x80).
+// widen(p, n, out) and narrow(p, n, out) copy n code units which are known to be ASCII to a wider or narrower format.
+// On x86 and x64 these use SSE2, and AVX2 when the processor supports it (determined once, at first use);
+// elsewhere they fall back to scalar code which examines eight bytes at a time.
+
+namespace utfsimd {
+
+    namespace scalar {
+
+        inline size_t ascii(const char* p, size_t n) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                uint64_t v;
+                memcpy(&v, p + i, 8);
+                if (v & 0x8080808080808080ull) break;
+            }
+            while (i < n && !(p[i] & 0x80)) ++i;
+            return i;
+        }
+
+        template<typename C> size_t ascii(const C* p, size_t n) {
+            size_t i = 0;
+            while (i < n && static_cast<std::make_unsigned_t<C>>(p[i]) < 0x80) ++i;
+            return i;
+        }
+
+        template<typename C> void widen(const char* p, size_t n, C* out) {
+            for (size_t i = 0; i < n; ++i) out[i] = static_cast<C>(p[i]);
+        }
+
+        template<typename C> void narrow(const C* p, size_t n, char* out) {
+            for (size_t i = 0; i < n; ++i) out[i] = static_cast<char>(p[i]);
+        }
+
+    }
+
+#ifdef UTFSIMD_X86
+
+    namespace sse2 {
+
+        inline size_t ascii(const char* p, size_t n) {
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+                if (mask) {
+                    unsigned long bit;
+#if defined(_MSC_VER) && !defined(__clang__)
+                    _BitScanForward(&bit, static_cast<unsigned long>(mask));
+#else
+                    bit = static_cast<unsigned long>(__builtin_ctz(static_cast<unsigned>(mask)));
+#endif
+                    return i + bit;
+                }
+            }
+            return i + scalar::ascii(p + i, n - i);
+        }
+
+        inline size_t ascii16(const uint16_t* p, size_t n) {
+            const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF80));
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, high), _mm_setzero_si128())) != 0xFFFF) break;
+            }
+            return i + scalar::ascii(p + i, n - i);
+        }
+
+        inline size_t ascii32(const uint32_t* p, size_t n) {
+            const __m128i high = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, high), _mm_setzero_si128())) != 0xFFFF) break;
+            }
+            return i + scalar::ascii(p + i, n - i);
+        }
+
+        inline void widen16(const char* p, size_t n, uint16_t* out) {
+            const __m128i zero = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i    ), _mm_unpacklo_epi8(v, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(v, zero));
+            }
+            scalar::widen(p + i, n - i, out + i);
+        }
+
+        inline void widen32(const char* p, size_t n, uint32_t* out) {
+            const __m128i zero = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i     ), _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i +  4), _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i +  8), _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+            }
+            scalar::widen(p + i, n - i, out + i);
+        }
+
+        inline void narrow16(const uint16_t* p, size_t n, char* out) {
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i    ));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 8));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+            }
+            scalar::narrow(p + i, n - i, out + i);
+        }
+
+        inline void narrow32(const uint32_t* p, size_t n, char* out) {
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m128i a = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i     )),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i +  4)));
+                __m128i b = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i +  8)),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 12)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+            }
+            scalar::narrow(p + i, n - i, out + i);
+        }
+
+    }
+
+    namespace avx2 {
+
+        UTFSIMD_AVX2 inline size_t ascii(const char* p, size_t n) {
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)))) break;
+            }
+            return i + sse2::ascii(p + i, n - i);
+        }
+
+        UTFSIMD_AVX2 inline void widen16(const char* p, size_t n, uint16_t* out) {
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvtepu8_epi16(v));
+            }
+            scalar::widen(p + i, n - i, out + i);
+        }
+
+        inline bool supported() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;  // OSXSAVE and AVX
+            if ((_xgetbv(0) & 6) != 6) return false;                                        // OS saves YMM state
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;                                               // AVX2
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+    }
+
+    struct Kernels {
+        size_t (*ascii8   )(const char*, size_t)            = sse2::ascii;
+        void   (*widen8_16)(const char*, size_t, uint16_t*) = sse2::widen16;
+        Kernels() {
+            if (avx2::supported()) {
+                ascii8    = avx2::ascii;
+                widen8_16 = avx2::widen16;
+            }
+        }
+    };
+
+    inline const Kernels& kernels() { static const Kernels k; return k; }
+
+    inline size_t ascii(const char*     p, size_t n) { return kernels().ascii8(p, n); }
+    inline size_t ascii(const char32_t* p, size_t n) { return sse2::ascii32(reinterpret_cast<const uint32_t*>(p), n); }
+    inline size_t ascii(const wchar_t*  p, size_t n) {
+        if constexpr (sizeof(wchar_t) == 2) return sse2::ascii16(reinterpret_cast<const uint16_t*>(p), n);
+        else                                return sse2::ascii32(reinterpret_cast<const uint32_t*>(p), n);
+    }
+
+    inline void widen(const char* p, size_t n, char32_t* out) { sse2::widen32(p, n, reinterpret_cast<uint32_t*>(out)); }
+    inline void widen(const char* p, size_t n, wchar_t*  out) {
+        if constexpr (sizeof(wchar_t) == 2) kernels().widen8_16(p, n, reinterpret_cast<uint16_t*>(out));
+        else                                sse2::widen32(p, n, reinterpret_cast<uint32_t*>(out));
+    }
+
+    inline void narrow(const char32_t* p, size_t n, char* out) { sse2::narrow32(reinterpret_cast<const uint32_t*>(p), n, out); }
+    inline void narrow(const wchar_t*  p, size_t n, char* out) {
+        if constexpr (sizeof(wchar_t) == 2) sse2::narrow16(reinterpret_cast<const uint16_t*>(p), n, out);
+        else                                sse2::narrow32(reinterpret_cast<const uint32_t*>(p), n, out);
+    }
+
+#else
+
+    using scalar::ascii;
+    using scalar::widen;
+    using scalar::narrow;
+
+#endif
+
+}
+
+
 // Translation between utf-8, utf-16 and utf-32
+//
+// Each conversion is written once, in the utfdetail namespace, against an output object which either counts
+// or stores code units.  For each conversion xtoy there are three public functions:
+//
+//     xtoy_length(input) returns the exact number of code units the converted string will contain;
+//     xtoy_into(input, out) converts into a caller-supplied buffer and returns the number of code units written;
+//     xtoy(input) returns the converted string, sized exactly using one counting pass and one converting pass.
+//
+// xtoy_into never writes past the end of out: if out is too small, nothing is written and utf_overflow is returned.
+// A buffer sized for the worst case never needs the counting pass; the worst cases, in output code units per input
+// code unit, are: utf8to16 1, utf8to32 1, utf16to32 1, utf32to16 2, utf16to8 3, utf32to8 4.
 
-inline std::u32string utf16to32(const std::wstring_view w) {
-    std::u32string u;
-    for (size_t i = 0; i < w.length(); ++i) {
-        if (w[i] >= 0xD800 && w[i] < 0xDC00 && i + 1 < w.length() && w[i + 1] >= 0xDC00 && w[i + 1] <= 0xDFFF) {
-            u += (static_cast<char32_t>(w[i] & 0x7FF) << 10 | (w[i + 1] & 0x03FF)) + 0x10000;
-            ++i;
+inline constexpr size_t utf_overflow = static_cast<size_t>(-1);
+
+namespace utfdetail {
+
+    template<typename C> struct Counter {
+        size_t n = 0;
+        void put(C) { ++n; }
+        template<typename A> void ascii(const A*, size_t k) { n += k; }
+    };
+
+    template<typename C> struct Writer {
+        C* const start;
+        C* p;
+        explicit Writer(C* out) : start(out), p(out) {}
+        void put(C c) { *p++ = c; }
+        template<typename A> void ascii(const A* a, size_t k) {
+            if constexpr (sizeof(A) < sizeof(C)) utfsimd::widen(a, k, p);
+            else                                 utfsimd::narrow(a, k, p);
+            p += k;
+        }
+        size_t count() const { return p - start; }
+    };
+
+    template<typename Out> void utf16to32(const std::wstring_view w, Out& out) {
+        for (size_t i = 0; i < w.length(); ++i) {
+            if (w[i] >= 0xD800 && w[i] < 0xDC00 && i + 1 < w.length() && w[i + 1] >= 0xDC00 && w[i + 1] <= 0xDFFF) {
+                out.put((static_cast<char32_t>(w[i] & 0x7FF) << 10 | (w[i + 1] & 0x03FF)) + 0x10000);
+                ++i;
+            }
+            else out.put(w[i]);
+        }
+    }
+
+    template<typename Out> void utf32to16(const std::u32string_view u, Out& out) {
+        for (size_t i = 0; i < u.length(); ++i) {
+            if (u[i] >= 0x10000) {
+                out.put(static_cast<wchar_t>(0xD800 + ((u[i] - 0x10000) >> 10)));
+                out.put(static_cast<wchar_t>(0xDC00 + (u[i] & 0x03FF)));
+            }
+            else out.put(static_cast<wchar_t>(u[i]));
+        }
+    }
+
+    template<typename Out> void utf8to32(const std::string_view s, InvalidUnicode errs, Out& out) {
+        for (size_t i = 0; i < s.length(); ++i) {
+            switch (utf8byte::implicit_length(s[i])) {
+            case 1:
+            {
+                size_t n = utfsimd::ascii(s.data() + i, s.length() - i);
+                out.ascii(s.data() + i, n);
+                i += n - 1;
+                continue;
+            }
+            case 2:
+                if (i + 1 >= s.length() || !utf8byte::isTrail(s[i + 1])) break;
+                out.put(utf8byte::to32(s[i], s[i + 1]));
+                i += 1;
+                continue;
+            case 3:
+                if (i + 2 >= s.length() || !utf8byte::isTrail(s[i + 1]) || !utf8byte::isTrail(s[i + 2])) break;
+                if ((errs != InvalidUnicode::Preserve_16 || s[i] != 0xED) && utf8byte::badPair(s[i], s[i + 1])) break;
+                out.put(static_cast<wchar_t>(utf8byte::to32(s[i], s[i + 1], s[i + 2])));
+                i += 2;
+                continue;
+            case 4:
+                if (i + 3 >= s.length() || !utf8byte::valid_trail(s[i], s[i + 1], s[i + 2]), s[i + 3]) break;
+                out.put(utf8byte::to32(s[i], s[i + 1], s[i + 2]));
+                i += 3;
+                continue;
+            }
+            out.put((errs == InvalidUnicode::Preserve_8) ? 0xDC00 + s[i] : 0xFFFD);
+        }
+    }
+
+    template<typename Out> void utf32to8(const std::u32string_view u, InvalidUnicode errs, Out& out) {
+        for (size_t i = 0; i < u.length(); ++i) {
+            char32_t c = u[i];
+            if (c < 0x80) {
+                size_t n = utfsimd::ascii(u.data() + i, u.length() - i);
+                out.ascii(u.data() + i, n);
+                i += n - 1;
+            }
+            else if (c < 0x800) {
+                out.put(static_cast<char>((c >> 6) | 0xC0));
+                out.put(static_cast<char>((c & 0x3F) | 0x80));
+            }
+            else if (c >= 0xD800 && c <= 0xDFFF && errs != InvalidUnicode::Preserve_16) {
+                if (errs == InvalidUnicode::Preserve_8 && (c >= 0xDC80 && c <= 0xDCFF)) out.put(static_cast<char>(0xFF & c));
+                else {
+                    out.put('\xEF');
+                    out.put('\xBF');
+                    out.put('\xBD');
+                }
+            }
+            else if (c <= 0x10000) {
+                out.put(static_cast<char>((c >> 12) | 0xE0));
+                out.put(static_cast<char>(((c >> 6) & 0x3F) | 0x80));
+                out.put(static_cast<char>((c & 0x3F) | 0x80));
+            }
+            else if (c <= 0x110000) {
+                out.put(static_cast<char>((c >> 18) | 0xF0));
+                out.put(static_cast<char>(((c >> 12) & 0x3F) | 0x80));
+                out.put(static_cast<char>(((c >> 6) & 0x3F) | 0x80));
+                out.put(static_cast<char>((c & 0x3F) | 0x80));
+            }
+            else {
+                out.put('\xEF');
+                out.put('\xBF');
+                out.put('\xBD');
+            }
         }
-        else u += w[i];
     }
+
+    template<typename Out> void utf8to16(const std::string_view s, InvalidUnicode errs, Out& out) {
+        for (size_t i = 0; i < s.length(); ++i) {
+            switch (utf8byte::implicit_length(s[i])) {
+            case 1:
+            {
+                size_t n = utfsimd::ascii(s.data() + i, s.length() - i);
+                out.ascii(s.data() + i, n);
+                i += n - 1;
+                continue;
+            }
+            case 2:
+                if (i + 1 >= s.length() || !utf8byte::isTrail(s[i + 1])) break;
+                out.put(static_cast<wchar_t>(utf8byte::to32(s[i], s[i + 1])));
+                i += 1;
+                continue;
+            case 3:
+                if (i + 2 >= s.length() || !utf8byte::isTrail(s[i + 1]) || !utf8byte::isTrail(s[i + 2])) break;
+                if ((errs != InvalidUnicode::Preserve_16 || s[i] != 0xED) && utf8byte::badPair(s[i], s[i + 1])) break;
+                out.put(static_cast<wchar_t>(utf8byte::to32(s[i], s[i + 1], s[i + 2])));
+                i += 2;
+                continue;
+            case 4:
+                if (i + 3 >= s.length() || !utf8byte::valid_trail(s[i], s[i + 1], s[i + 2], s[i + 3])) break;
+                char32_t u = utf8byte::to32(s[i], s[i + 1], s[i + 2], s[i + 3]);
+                out.put(static_cast<wchar_t>(0xD800 + ((u - 0x10000) >> 10)));
+                out.put(static_cast<wchar_t>(0xDC00 + (u & 0x03FF)));
+                i += 3;
+                continue;
+            }
+            out.put(static_cast<wchar_t>((errs == InvalidUnicode::Preserve_8) ? 0xDC00 + s[i] : 0xFFFD));
+        }
+    }
+
+    template<typename Out> void utf16to8(const std::wstring_view w, InvalidUnicode errs, Out& out) {
+        for (size_t i = 0; i < w.length(); ++i) {
+            wchar_t c = w[i];
+            if (static_cast<std::make_unsigned_t<wchar_t>>(c) < 0x80) {
+                size_t n = utfsimd::ascii(w.data() + i, w.length() - i);
+                out.ascii(w.data() + i, n);
+                i += n - 1;
+            }
+            else if (c < 0x800) {
+                out.put(static_cast<char>((c >> 6) | 0xC0));
+                out.put(static_cast<char>((c & 0x3F) | 0x80));
+            }
+            else if (c < 0xD800 && c > 0xDFFF) {
+                out.put(static_cast<char>((c >> 12) | 0xE0));
+                out.put(static_cast<char>(((c >> 6) & 0x3F) | 0x80));
+                out.put(static_cast<char>((c & 0x3F) | 0x80));
+            }
+            else {
+                if (i + 1 < w.length() && w[i + 1] >= 0xDC00 && w[i + 1] <= 0xDFFF) {
+                    char32_t u = (static_cast<char32_t>(c & 0x7FF) << 10 | (w[i + 1] & 0x03FF)) + 0x10000;
+                    out.put(static_cast<char>((u >> 18) | 0xF0));
+                    out.put(static_cast<char>(((u >> 12) & 0x3F) | 0x80));
+                    out.put(static_cast<char>(((u >> 6) & 0x3F) | 0x80));
+                    out.put(static_cast<char>((u & 0x3F) | 0x80));
+                    ++i;
+                }
+                else if (errs == InvalidUnicode::Preserve_8 && (c >= 0xDC80 && c <= 0xDCFF)) out.put(static_cast<char>(0xFF & c));
+                else if (errs == InvalidUnicode::Preserve_16) {
+                    out.put(static_cast<char>(0xED));
+                    out.put(static_cast<char>(((c >> 6) & 0x3F) | 0x80));
+                    out.put(static_cast<char>((c & 0x3F) | 0x80));
+                }
+                else {
+                    out.put('\xEF');
+                    out.put('\xBF');
+                    out.put('\xBD');
+                }
+            }
+        }
+    }
+
+}
+
+
+inline size_t utf16to32_length(const std::wstring_view w) {
+    utfdetail::Counter<char32_t> counter;
+    utfdetail::utf16to32(w, counter);
+    return counter.n;
+}
+
+inline size_t utf16to32_into(const std::wstring_view w, std::span<char32_t> out) {
+    if (out.size() < w.length() && out.size() < utf16to32_length(w)) return utf_overflow;
+    utfdetail::Writer<char32_t> writer(out.data());
+    utfdetail::utf16to32(w, writer);
+    return writer.count();
+}
+
+inline std::u32string utf16to32(const std::wstring_view w) {
+    std::u32string u(utf16to32_length(w), 0);
+    utfdetail::Writer<char32_t> writer(u.data());
+    utfdetail::utf16to32(w, writer);
     return u;
 }
 
+
+inline size_t utf32to16_length(const std::u32string_view u) {
+    utfdetail::Counter<wchar_t> counter;
+    utfdetail::utf32to16(u, counter);
+    return counter.n;
+}
+
+inline size_t utf32to16_into(const std::u32string_view u, std::span<wchar_t> out) {
+    if (out.size() < 2 * u.length() && out.size() < utf32to16_length(u)) return utf_overflow;
+    utfdetail::Writer<wchar_t> writer(out.data());
+    utfdetail::utf32to16(u, writer);
+    return writer.count();
+}
+
 inline std::wstring utf32to16(const std::u32string_view u) {
-    std::wstring w;
-    for (size_t i = 0; i < u.length(); ++i) {
-        if (u[i] >= 0x10000) {
-            w += static_cast<wchar_t>(0xD800 + ((u[i] - 0x10000) >> 10));
-            w += static_cast<wchar_t>(0xDC00 + (u[i] & 0x03FF));
-        }
-        else w += static_cast<wchar_t>(u[i]);
-    }
+    std::wstring w(utf32to16_length(u), 0);
+    utfdetail::Writer<wchar_t> writer(w.data());
+    utfdetail::utf32to16(u, writer);
     return w;
 }
 
+
+inline size_t utf8to32_length(const std::string_view s, InvalidUnicode errs = InvalidUnicode::Substitute) {
+    utfdetail::Counter<char32_t> counter;
+    utfdetail::utf8to32(s, errs, counter);
+    return counter.n;
+}
+
+inline size_t utf8to32_into(const std::string_view s, std::span<char32_t> out, InvalidUnicode errs = InvalidUnicode::Substitute) {
+    if (out.size() < s.length() && out.size() < utf8to32_length(s, errs)) return utf_overflow;
+    utfdetail::Writer<char32_t> writer(out.data());
+    utfdetail::utf8to32(s, errs, writer);
+    return writer.count();
+}
+
 inline std::u32string utf8to32(const std::string_view s, InvalidUnicode errs = InvalidUnicode::Substitute) {
-    std::u32string u;
-    for (size_t i = 0; i < s.length(); ++i) {
-        switch (utf8byte::implicit_length(s[i])) {
-        case 1:
-            u += s[i];
-            continue;
-        case 2:
-            if (i + 1 >= s.length() || !utf8byte::isTrail(s[i + 1])) break;
-            u += utf8byte::to32(s[i], s[i + 1]);
-            i += 1;
-            continue;
-        case 3:
-            if (i + 2 >= s.length() || !utf8byte::isTrail(s[i + 1]) || !utf8byte::isTrail(s[i + 2])) break;
-            if ((errs != InvalidUnicode::Preserve_16 || s[i] != 0xED) && utf8byte::badPair(s[i], s[i + 1])) break;
-            u += static_cast<wchar_t>(utf8byte::to32(s[i], s[i + 1], s[i + 2]));
-            i += 2;
-            continue;
-        case 4:
-            if (i + 3 >= s.length() || !utf8byte::valid_trail(s[i], s[i + 1], s[i + 2]), s[i + 3]) break;
-            u += utf8byte::to32(s[i], s[i + 1], s[i + 2]);
-            i += 3;
-            continue;
-        }
-        u += (errs == InvalidUnicode::Preserve_8) ? 0xDC00 + s[i] : 0xFFFD;
-    }
+    std::u32string u(utf8to32_length(s, errs), 0);
+    utfdetail::Writer<char32_t> writer(u.data());
+    utfdetail::utf8to32(s, errs, writer);
     return u;
 }
 
+
+inline size_t utf32to8_length(const std::u32string_view u, InvalidUnicode errs = InvalidUnicode::Substitute) {
+    utfdetail::Counter<char> counter;
+    utfdetail::utf32to8(u, errs, counter);
+    return counter.n;
+}
+
+inline size_t utf32to8_into(const std::u32string_view u, std::span<char> out, InvalidUnicode errs = InvalidUnicode::Substitute) {
+    if (out.size() < 4 * u.length() && out.size() < utf32to8_length(u, errs)) return utf_overflow;
+    utfdetail::Writer<char> writer(out.data());
+    utfdetail::utf32to8(u, errs, writer);
+    return writer.count();
+}
+
 inline std::string utf32to8(const std::u32string_view u, InvalidUnicode errs = InvalidUnicode::Substitute) {
-    std::string s;
-    for (auto c : u) {
-        if (c < 0x80) s += static_cast<char>(c);
-        else if (c < 0x800) {
-            s += static_cast<char>((c >> 6) | 0xC0);
-            s += static_cast<char>((c & 0x3F) | 0x80);
-        }
-        else if (c >= 0xD800 && c <= 0xDFFF && errs != InvalidUnicode::Preserve_16) {
-            if (errs == InvalidUnicode::Preserve_8 && (c >= 0xDC80 && c <= 0xDCFF)) s += static_cast<char>(0xFF & c);
-            else s += "\xEF\xBF\xBD";
-        }
-        else if (c <= 0x10000) {
-            s += static_cast<char>((c >> 12) | 0xE0);
-            s += static_cast<char>(((c >> 6) & 0x3F) | 0x80);
-            s += static_cast<char>((c & 0x3F) | 0x80);
-        }
-        else if (c <= 0x110000){
-            s += static_cast<char>((c >> 18) | 0xF0);
-            s += static_cast<char>(((c >> 12) & 0x3F) | 0x80);
-            s += static_cast<char>(((c >> 6) & 0x3F) | 0x80);
-            s += static_cast<char>((c & 0x3F) | 0x80);
-        }
-        else s += "\xEF\xBF\xBD";
-    }
+    std::string s(utf32to8_length(u, errs), 0);
+    utfdetail::Writer<char> writer(s.data());
+    utfdetail::utf32to8(u, errs, writer);
     return s;
 }
 
+
+inline size_t utf8to16_length(const std::string_view s, InvalidUnicode errs = InvalidUnicode::Substitute) {
+    utfdetail::Counter<wchar_t> counter;
+    utfdetail::utf8to16(s, errs, counter);
+    return counter.n;
+}
+
+inline size_t utf8to16_into(const std::string_view s, std::span<wchar_t> out, InvalidUnicode errs = InvalidUnicode::Substitute) {
+    if (out.size() < s.length() && out.size() < utf8to16_length(s, errs)) return utf_overflow;
+    utfdetail::Writer<wchar_t> writer(out.data());
+    utfdetail::utf8to16(s, errs, writer);
+    return writer.count();
+}
+
 inline std::wstring utf8to16(const std::string_view s, InvalidUnicode errs = InvalidUnicode::Substitute) {
-    std::wstring w;
-    for (size_t i = 0; i < s.length(); ++i) {
-        switch (utf8byte::implicit_length(s[i])) {
-        case 1:
-            w += s[i];
-            continue;
-        case 2:
-            if (i + 1 >= s.length() || !utf8byte::isTrail(s[i + 1])) break;
-            w += static_cast<wchar_t>(utf8byte::to32(s[i], s[i + 1]));
-            i += 1;
-            continue;
-        case 3:
-            if (i + 2 >= s.length() || !utf8byte::isTrail(s[i + 1]) || !utf8byte::isTrail(s[i + 2])) break;
-            if ((errs != InvalidUnicode::Preserve_16 || s[i] != 0xED) && utf8byte::badPair(s[i], s[i + 1])) break;
-            w += static_cast<wchar_t>(utf8byte::to32(s[i], s[i + 1], s[i + 2]));
-            i += 2;
-            continue;
-        case 4:
-            if (i + 3 >= s.length() || !utf8byte::valid_trail(s[i], s[i + 1], s[i + 2], s[i + 3])) break;
-            char32_t u = utf8byte::to32(s[i], s[i + 1], s[i + 2], s[i + 3]);
-            w += static_cast<wchar_t>(0xD800 + ((u - 0x10000) >> 10));
-            w += static_cast<wchar_t>(0xDC00 + (u & 0x03FF));
-            i += 3;
-            continue;
-        }
-        w += (errs == InvalidUnicode::Preserve_8) ? 0xDC00 + s[i] : 0xFFFD;
-    }
+    std::wstring w(utf8to16_length(s, errs), 0);
+    utfdetail::Writer<wchar_t> writer(w.data());
+    utfdetail::utf8to16(s, errs, writer);
     return w;
 }
 
+
+inline size_t utf16to8_length(const std::wstring_view w, InvalidUnicode errs = InvalidUnicode::Substitute) {
+    utfdetail::Counter<char> counter;
+    utfdetail::utf16to8(w, errs, counter);
+    return counter.n;
+}
+
+inline size_t utf16to8_into(const std::wstring_view w, std::span<char> out, InvalidUnicode errs = InvalidUnicode::Substitute) {
+    if (out.size() < 3 * w.length() && out.size() < utf16to8_length(w, errs)) return utf_overflow;
+    utfdetail::Writer<char> writer(out.data());
+    utfdetail::utf16to8(w, errs, writer);
+    return writer.count();
+}
+
 inline std::string utf16to8(const std::wstring_view w, InvalidUnicode errs = InvalidUnicode::Substitute) {
-    std::string s;
-    for (size_t i = 0; i < w.length(); ++i) {
-        wchar_t c = w[i];
-        if (c < 0x80) s += static_cast<char>(c);
-        else if (c < 0x800) {
-            s += static_cast<char>((c >> 6) | 0xC0);
-            s += static_cast<char>((c & 0x3F) | 0x80);
-        }
-        else if (c < 0xD800 && c > 0xDFFF) {
-            s += static_cast<char>((c >> 12) | 0xE0);
-            s += static_cast<char>(((c >> 6) & 0x3F) | 0x80);
-            s += static_cast<char>((c & 0x3F) | 0x80);
-        }
-        else {
-            if (i + 1 < w.length() && w[i + 1] >= 0xDC00 && w[i + 1] <= 0xDFFF) {
-                char32_t u = (static_cast<char32_t>(c & 0x7FF) << 10 | (w[i + 1] & 0x03FF)) + 0x10000;
-                s += static_cast<char>((u >> 18) | 0xF0);
-                s += static_cast<char>(((u >> 12) & 0x3F) | 0x80);
-                s += static_cast<char>(((u >> 6) & 0x3F) | 0x80);
-                s += static_cast<char>((u & 0x3F) | 0x80);
-                ++i;
-            }
-            else if (errs == InvalidUnicode::Preserve_8 && (c >= 0xDC80 && c <= 0xDCFF)) s += static_cast<char>(0xFF & c);
-            else if (errs == InvalidUnicode::Preserve_16) {
-                s += static_cast<char>(0xED);
-                s += static_cast<char>(((c >> 6) & 0x3F) | 0x80);
-                s += static_cast<char>((c & 0x3F) | 0x80);
-            }
-            else s += "\xEF\xBF\xBD";
-        }
-    }
+    std::string s(utf16to8_length(w, errs), 0);
+    utfdetail::Writer<char> writer(s.data());
+    utfdetail::utf16to8(w, errs, writer);
     return s;
-}
\ No newline at end of file
+}
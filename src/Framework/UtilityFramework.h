@@ -19,7 +19,11 @@
 
 
 #pragma once
+#include <cstdint>
+#include <unordered_map>
 #include "PluginFramework.h"
+#include "RefreshScheduler.h"
+#include "StreamTranscoder.h"
 #include "UnicodeFormatTranslation.h"
 #include "UtilityFrameworkMIT.h"
 
@@ -45,18 +49,28 @@ inline std::string  fromWide(std::wstring_view s) { return fromWide(s, plugin.sc
 inline std::wstring toWide  (std::string_view  s) { return   toWide(s, plugin.sci.CodePage()); }
 
 
+// Convert a range of the active Scintilla document to UTF-16 in fixed memory, reading it one window at a time
+// with RangePointer and passing each converted piece, as a std::wstring_view, to sink.
+
+template<typename Sink> void documentToWide(Scintilla::Position start, Scintilla::Position end, Sink&& sink) {
+    constexpr Scintilla::Position window = 1 << 20;
+    StreamToWide converter(plugin.sci.CodePage());
+    for (Scintilla::Position p = start; p < end; p += window) {
+        Scintilla::Position n = std::min(window, end - p);
+        auto text = static_cast<const char*>(plugin.sci.RangePointer(p, n));
+        converter.convert(std::string_view(text, n), false, sink);
+    }
+    converter.finish(sink);
+}
+
+
 // Get the full path of a file open in Notepad++ as a std::wstring.
 // If an argument is supplied, it is the Notepad++ buffer id to be examined.
 // If no argument is given, the current buffer is examined; this only works in commands and NPPN_BUFFERACTIVATED notifications,
 // since in Scintilla notifications and most Notepad++ notifications, the "current buffer" is not necessarily meaningful.
+// The form taking a buffer id is defined below, using BufferInfoCache.
 
-inline std::wstring getFilePath(UINT_PTR buffer) {
-    auto n = SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, buffer, 0);
-    if (n < 1) return L"";
-    std::wstring s(n, 0);
-    SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, buffer, (LPARAM)s.data());
-    return s;
-}
+inline std::wstring getFilePath(UINT_PTR buffer);
 inline std::wstring getFilePath() { return getFilePath(SendMessage(plugin.nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0)); }
 
 
@@ -74,5 +88,53 @@ inline std::wstring getFileExtension(const std::wstring& filepath) {
     wcslwr(ext.data());
     return ext;
 }
-inline std::wstring getFileExtension(UINT_PTR buffer) { return getFileExtension(getFilePath(buffer)); }
+inline std::wstring getFileExtension(UINT_PTR buffer);
 inline std::wstring getFileExtension() { return getFileExtension(SendMessage(plugin.nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0)); }
+
+
+// Information about a buffer, cached by buffer id so that repeated requests don't need to ask Notepad++ again.
+// beNotified discards the information for a buffer on NPPN_FILEOPENED, NPPN_FILECLOSED, NPPN_FILERENAMED,
+// NPPN_FILESAVED and NPPN_LANGCHANGED, even when bypassing notifications.  Notepad++ does not notify plugins when
+// the user changes a buffer's encoding or end of line format; call BufferInfoCache::forget if those must be current.
+// The cache is used only on the main thread, so it is not protected by a lock.
+
+struct BufferInfo {
+    std::wstring  path;       // as from NPPM_GETFULLPATHFROMBUFFERID
+    std::wstring  extension;  // as from getFileExtension
+    NPP::LangType language;   // as from NPPM_GETBUFFERLANGTYPE
+    int           encoding;   // as from NPPM_GETBUFFERENCODING
+    int           eolFormat;  // as from NPPM_GETBUFFERFORMAT
+};
+
+class BufferInfoCache {
+    static inline std::unordered_map<UINT_PTR, BufferInfo> cache;
+public:
+    static inline uint64_t hits   = 0;
+    static inline uint64_t misses = 0;
+
+    static const BufferInfo& get(UINT_PTR buffer) {
+        auto [entry, added] = cache.try_emplace(buffer);
+        if (!added) {
+            ++hits;
+            return entry->second;
+        }
+        ++misses;
+        BufferInfo& info = entry->second;
+        auto n = SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, buffer, 0);
+        if (n > 0) {
+            info.path.resize(n);
+            SendMessage(plugin.nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, buffer, (LPARAM)info.path.data());
+        }
+        info.extension = getFileExtension(info.path);
+        info.language  = static_cast<NPP::LangType>(SendMessage(plugin.nppData._nppHandle, NPPM_GETBUFFERLANGTYPE, buffer, 0));
+        info.encoding  = static_cast<int>(SendMessage(plugin.nppData._nppHandle, NPPM_GETBUFFERENCODING, buffer, 0));
+        info.eolFormat = static_cast<int>(SendMessage(plugin.nppData._nppHandle, NPPM_GETBUFFERFORMAT  , buffer, 0));
+        return info;
+    }
+
+    static void forget(UINT_PTR buffer) { cache.erase(buffer); }
+    static void clear() { cache.clear(); }
+};
+
+inline std::wstring getFilePath     (UINT_PTR buffer) { return BufferInfoCache::get(buffer).path;      }
+inline std::wstring getFileExtension(UINT_PTR buffer) { return BufferInfoCache::get(buffer).extension; }
@@ -30,62 +30,7 @@
 #define NOMINMAX
 #include <windows.h>
 #include <commctrl.h>
-
-
-// Convert between Windows utf-16 strings and Scintilla's ANSI or utf-8 strings, even if they are very long.
-
-inline std::string fromWide(std::wstring_view s, unsigned int codepage) {
-    constexpr unsigned int safeSize = std::numeric_limits<int>::max() / 4;
-    std::string r;
-    const wchar_t* start = s.data();
-    const wchar_t* stop  = start + s.length();
-    while (start < stop) {
-        size_t remainingLength = stop - start;
-        int inputLength;
-        if (remainingLength <= safeSize) inputLength = static_cast<int>(remainingLength);
-        else {
-            inputLength = safeSize;
-            wchar_t wc = start[inputLength - 1];
-            if (wc >= 0xD800 && wc <= 0xDBFF) --inputLength;  // leave leading surrogate for next block
-        }
-        int outputLength = WideCharToMultiByte(codepage, 0, start, inputLength, 0, 0, 0, 0);
-        size_t outputPoint = r.length();
-        r.resize(outputPoint + outputLength);
-        WideCharToMultiByte(codepage, 0, start, inputLength, r.data() + outputPoint, outputLength, 0, 0);
-        start += inputLength;
-    }
-    return r;
-}
-
-inline std::wstring toWide(std::string_view s, unsigned int codepage) {
-    constexpr unsigned int safeSize = std::numeric_limits<int>::max() / 2;
-    std::wstring r;
-    const char* start = s.data();
-    const char* stop  = start + s.length();
-    while (start < stop) {
-        size_t remainingLength = stop - start;
-        int inputLength;
-        if (remainingLength <= safeSize)
-            inputLength = static_cast<int>(remainingLength);
-        else if (codepage == CP_UTF8) {
-            inputLength = safeSize;
-            int inputMinimum = safeSize - 3;
-            while ((start[inputLength] & 0xC0) == 0x80)
-                if (inputLength > inputMinimum) --inputLength;
-                else inputLength = safeSize;  // invalid utf-8; reset so we don't truncate possibly valid continuation before bad bytes
-        }
-        else {
-            inputLength = static_cast<int>(CharPrevExA(static_cast<WORD>(codepage), start, start + safeSize + 1, 0) - start);
-            if (!inputLength) inputLength = safeSize;  // make sure invalid input won't cause a crash or hard loop
-        }
-        int outputLength = MultiByteToWideChar(codepage, 0, start, inputLength, 0, 0);
-        size_t outputPoint = r.length();
-        r.resize(outputPoint + outputLength);
-        MultiByteToWideChar(codepage, 0, start, inputLength, r.data() + outputPoint, outputLength);
-        start += inputLength;
-    }
-    return r;
-}
+#include "CodePageConversion.h"
 
 
 // Get the text from a Window or a from a control in a dialog as a std::wstring
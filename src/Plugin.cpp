@@ -15,6 +15,11 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "Framework/PluginFramework.h"
+#include "Framework/DocumentView.h"
+#include "Framework/NotificationDispatcher.h"
+#include "Framework/RefreshScheduler.h"
+#include "Framework/TaskPool.h"
+#include "Framework/UtilityFramework.h"
 using namespace NPP;
 
 
@@ -22,6 +27,8 @@ using namespace NPP;
 
 void loadConfiguration();
 void saveConfiguration();
+void saveInstrumentation();
+std::wstring saveTrace();
 
 // Routines that process Scintilla notifications
 
@@ -35,6 +42,8 @@ void bufferActivated();
 void fileClosed(const NMHDR*);
 void fileOpened(const NMHDR*);
 void modifyAll(const NMHDR*);
+void nppReady(const NMHDR*);     // defined below
+void nppShutdown(const NMHDR*);  // defined below
 
 // Routines that process menu commands
 
@@ -42,8 +51,13 @@ void listOpenFiles();
 void showAboutDialog();
 void showSettingsDialog();
 void toggleStatusDialog();
+void toggleTrace();
 void toggleWatcherPanel();
 
+// Routines that must be called at shutdown
+
+void stopWatcherSearch();
+
 
 // Name and define any shortcut keys to be assigned as menu item defaults: Ctrl, Alt, Shift and the virtual key code
 //
@@ -51,6 +65,7 @@ void toggleWatcherPanel();
 //     text to appear on menu (ignored for a menu separator line)
 //     address of a void, zero-argument function that processes the command (0 for a menu separator line)
 //         recommended: use plugin.cmd, per examples, to wrap the function, setting Scintilla pointers and bypassing notifications
+//         (the second argument to plugin.cmd names the command in Instrumentation reports)
 //     ignored on call; on return, Notepad++ will fill this in with the menu command ID it assigns
 //     whether to show a checkmark beside this item on initial display of the menu
 //     0 or default shortcut key (menu accelerator) specified as the address of an NPP::ShortcutKey structure
@@ -66,16 +81,18 @@ void toggleWatcherPanel();
 static ShortcutKey SKToggleStatus { true, true, true, VK_HOME };
 
 FuncItem menuDefinition[] = {
-    { L"Insert List of Open Files", []() {plugin.cmd(listOpenFiles     );}, 0, false, 0               },
-    { L"Show Status"              , []() {plugin.cmd(toggleStatusDialog);}, 0, false, &SKToggleStatus },
-    { L"Show Watcher Panel"       , []() {plugin.cmd(toggleWatcherPanel);}, 0, false, 0               },
-    { 0                           , 0                                     , 0, false, 0               },
-    { L"Settings..."              , []() {plugin.cmd(showSettingsDialog);}, 0, false, 0               },
-    { L"Help/About..."            , []() {plugin.cmd(showAboutDialog   );}, 0, false, 0               }
+    { L"Insert List of Open Files", []() {plugin.cmd(listOpenFiles     , "listOpenFiles"     );}, 0, false, 0               },
+    { L"Show Status"              , []() {plugin.cmd(toggleStatusDialog, "toggleStatusDialog");}, 0, false, &SKToggleStatus },
+    { L"Show Watcher Panel"       , []() {plugin.cmd(toggleWatcherPanel, "toggleWatcherPanel");}, 0, false, 0               },
+    { L"Capture Trace"            , []() {plugin.cmd(toggleTrace       , "toggleTrace"       );}, 0, false, 0               },
+    { 0                           , 0                                                           , 0, false, 0               },
+    { L"Settings..."              , []() {plugin.cmd(showSettingsDialog, "showSettingsDialog");}, 0, false, 0               },
+    { L"Help/About..."            , []() {plugin.cmd(showAboutDialog   , "showAboutDialog"   );}, 0, false, 0               }
 };
 
 int menuItem_ToggleStatus  = 1;
 int menuItem_ToggleWatcher = 2;
+int menuItem_ToggleTrace   = 3;
 
 
 // Tell Notepad++ the plugin name
@@ -95,101 +112,86 @@ extern "C" __declspec(dllexport) FuncItem * getFuncsArray(int *n) {
 
 
 // Notification processing: each notification desired must be sent to a function that will handle it.
+//
+// Define notification handlers:
+//     notification code: NPPN_... for Notepad++ notifications, Scintilla::Notification::... for Scintilla notifications
+//     address of a void function that processes the notification, taking a const NMHDR* for Notepad++ notifications
+//         or a const Scintilla::NotificationData* for Scintilla notifications
+//     0 or NotificationFilter values, combined with |, to skip the handler during startup and shutdown or while a
+//         file is opening, and to set the Scintilla pointers before calling it
+//     for Scintilla::Notification::Modified only, the modification flags the handler needs (0 for any)
+//
+// Note that most of the notifications listed below have some connection to plugin framework code;
+// it's best to leave those and just remove any function calls you don't use.  Scintilla notifications
+// are examples; use only the notifications you need.
+
+NotificationHandler notificationDefinition[] = {
+    { NPPN_BEFORESHUTDOWN              , [](const NMHDR*) { plugin.startupOrShutdown = true;  }                                    },
+    { NPPN_BUFFERACTIVATED             , [](const NMHDR*) { bufferActivated(); }
+                                       , notDuringStartupOrShutdown | notWhileFileIsOpening | setScintillaPointers                 },
+    { NPPN_CANCELSHUTDOWN              , [](const NMHDR*) { plugin.startupOrShutdown = false; }                                    },
+    { NPPN_FILEBEFOREOPEN              , [](const NMHDR*) { plugin.fileIsOpening = true;      }                                    },
+    { NPPN_FILECLOSED                  , fileClosed                                                                                },
+    { NPPN_FILEOPENED                  , [](const NMHDR*) { plugin.fileIsOpening = false;     }                                    },
+    { NPPN_FILEOPENED                  , fileOpened                                                                                },
+    { NPPN_GLOBALMODIFIED              , modifyAll                                                                                 },
+    { NPPN_READY                       , nppReady                                                                                  },
+    { NPPN_SHUTDOWN                    , nppShutdown                                                                               },
+    { Scintilla::Notification::Modified, scnModified, setScintillaPointers, SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT                  },
+    { Scintilla::Notification::UpdateUI, scnUpdateUI, setScintillaPointers                                                         },
+    { Scintilla::Notification::Zoom    , scnZoom    , setScintillaPointers                                                         }
+};
 
-extern "C" __declspec(dllexport) void beNotified(SCNotification *np) {
-
-    if (plugin.bypassNotifications) return;
-    plugin.bypassNotifications = true;
-    auto*& nmhdr = reinterpret_cast<NMHDR*&>(np);
-
-    // Example Notepad++ notifications; you can add others as needed.
-    // Note that most of the notifications listed below have some connection to plugin framework code;
-    // it's best to leave those and just remove any function calls you don't use.
-
-    if (nmhdr->hwndFrom == plugin.nppData._nppHandle) {
-      
-        switch (nmhdr->code) {
-
-        case NPPN_BEFORESHUTDOWN:
-            plugin.startupOrShutdown = true;
-            break;
-
-        case NPPN_BUFFERACTIVATED:
-            if (!plugin.startupOrShutdown && !plugin.fileIsOpening) {
-                plugin.getScintillaPointers();
-                bufferActivated();
-            }
-            break;
-
-        case NPPN_CANCELSHUTDOWN:
-            plugin.startupOrShutdown = false;
-            break;
-
-        case NPPN_FILEBEFOREOPEN:
-            plugin.fileIsOpening = true;
-            break;
-
-        case NPPN_FILECLOSED:
-            fileClosed(nmhdr);
-            break;
-
-        case NPPN_FILEOPENED:
-            plugin.fileIsOpening = false;
-            fileOpened(nmhdr);
-            break;
-
-        case NPPN_GLOBALMODIFIED:
-            modifyAll(nmhdr);
-            break;
-
-        case NPPN_READY:
-            // If you use Scintilla::Notification::Modified, send the following message to tell Notepad++
-            // which events you need; https://www.scintilla.org/ScintillaDoc.html#SCN_MODIFIED lists them.
-            // Note that this does not mean you will not get messages for other events; it only specifies that
-            // you do want at least the ones you list.  You still must test and return quickly from messages
-            // you don't need.  If you don't use Scintilla::Notification::Modified, remove the next line.
-            SendMessage(plugin.nppData._nppHandle, NPPM_ADDSCNMODIFIEDFLAGS, 0, SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT);                  
-            plugin.startupOrShutdown = false;
-            plugin.getScintillaPointers();
-            bufferActivated();
-            break;
-
-        case NPPN_SHUTDOWN:
-            saveConfiguration();
-            break;
-
-        }
+NotificationDispatcher notifications(notificationDefinition);
 
-    }
 
-    // Example Scintilla notifications; use only the notifications you need.
+// Notepad++ notifications handled here, because they involve the framework or several parts of the plugin
 
-    else if (nmhdr->hwndFrom == plugin.nppData._scintillaMainHandle || nmhdr->hwndFrom == plugin.nppData._scintillaSecondHandle) {
+void nppReady(const NMHDR*) {
+    ConfigurationLoad::start();  // read the configuration file on a background thread
+    // If you use Scintilla::Notification::Modified, the following message tells Notepad++ which events you need;
+    // notifications.modificationFlags() combines the flags listed for it in notificationDefinition (above), and
+    // https://www.scintilla.org/ScintillaDoc.html#SCN_MODIFIED lists them.  Note that this does not mean you will not
+    // get messages for other events; it only specifies that you do want at least the ones you list.
+    SendMessage(plugin.nppData._nppHandle, NPPM_ADDSCNMODIFIEDFLAGS, 0, notifications.modificationFlags());
+    plugin.startupOrShutdown = false;
+    plugin.getScintillaPointers();
+    bufferActivated();
+}
 
-        auto*& scnp = reinterpret_cast<Scintilla::NotificationData*&>(np);
-        switch (scnp->nmhdr.code) {
+void nppShutdown(const NMHDR*) {
+    RefreshScheduler::cancel();
+    stopWatcherSearch();
+    taskPool.shutdown();
+    ConfigurationLoad::wait();  // a load still running might post to the user interface thread
+    destroyUiWindow();
+    if (Instrumentation::on()) saveInstrumentation();
+    if (Trace::on()) {
+        Trace::stop();
+        saveTrace();
+    }
+    saveConfiguration();
+}
 
-        case Scintilla::Notification::Modified:
-            plugin.getScintillaPointers(scnp);
-            scnModified(scnp);
-            break;
 
-        case Scintilla::Notification::UpdateUI:
-            plugin.getScintillaPointers(scnp);
-            scnUpdateUI(scnp);
-            break;
+extern "C" __declspec(dllexport) void beNotified(SCNotification *np) {
 
-        case Scintilla::Notification::Zoom:
-            plugin.getScintillaPointers(scnp);
-            scnZoom(scnp);
-            break;
+    auto*& nmhdr = reinterpret_cast<NMHDR*&>(np);
 
-        default:;
-        }
+    // Framework housekeeping which must happen even if notifications are bypassed
 
+    if (nmhdr->code == static_cast<UINT>(Scintilla::Notification::Modified) || nmhdr->code == NPPN_GLOBALMODIFIED)
+        DocumentView::modified();
+    else if (nmhdr->hwndFrom == plugin.nppData._nppHandle && (nmhdr->code == NPPN_BUFFERACTIVATED || nmhdr->code == NPPN_READY)) {
+        plugin.forgetCurrentScintilla();
+        if (nmhdr->code == NPPN_BUFFERACTIVATED) DocumentView::modified();
+    }
+    else if (nmhdr->hwndFrom == plugin.nppData._nppHandle) switch (nmhdr->code) {
+        case NPPN_FILEOPENED: case NPPN_FILECLOSED: case NPPN_FILERENAMED: case NPPN_FILESAVED: case NPPN_LANGCHANGED:
+            BufferInfoCache::forget(nmhdr->idFrom);
     }
 
-    plugin.bypassNotifications = false;
+    notifications.dispatch(nmhdr);
 
 }
 
@@ -16,15 +16,71 @@
 
 #include "CommonData.h"
 
+extern NPP::FuncItem menuDefinition[];  // Defined in Plugin.cpp
+extern int menuItem_ToggleTrace;        // Defined in Plugin.cpp
+
+std::wstring saveTrace();               // Defined in Configuration.cpp
+
+
+// listOpenFiles can be asked to list thousands of files, so it refers to the paths in BufferInfoCache without copying
+// them, builds the list in a string allocated once at its final size, and converts and inserts it in pieces of
+// bounded size, all as a single undo action.
+
 void listOpenFiles() {
     Scintilla::EndOfLine eolMode = sci.EOLMode();
-    std::wstring eol = eolMode == Scintilla::EndOfLine::Cr ? L"\r"
-                     : eolMode == Scintilla::EndOfLine::Lf ? L"\n"
-                     : L"\r\n";
-    std::wstring filenames = data.heading.get() + eol;
+    std::wstring_view eol = eolMode == Scintilla::EndOfLine::Cr ? L"\r"
+                          : eolMode == Scintilla::EndOfLine::Lf ? L"\n"
+                          : L"\r\n";
+    std::wstring heading = data.heading.get();
+
+    std::vector<const std::wstring*> order;  // references to cache entries remain valid as entries are added
     for (int view = 0; view < 2; ++view) if (npp(NPPM_GETCURRENTDOCINDEX, 0, view)) {
         size_t n = npp(NPPM_GETNBOPENFILES, 0, view + 1);
-        for (size_t i = 0; i < n; ++i) filenames += getFilePath(npp(NPPM_GETBUFFERIDFROMPOS, i, view)) + eol;
+        for (size_t i = 0; i < n; ++i) order.push_back(&BufferInfoCache::get(npp(NPPM_GETBUFFERIDFROMPOS, i, view)).path);
+    }
+
+    size_t length = heading.length() + eol.length() * (order.size() + 1);
+    for (const std::wstring* path : order) length += path->length();
+    std::wstring filenames;
+    filenames.reserve(length);
+    filenames += heading;
+    filenames += eol;
+    for (const std::wstring* path : order) {
+        filenames += *path;
+        filenames += eol;
+    }
+
+    Scintilla::Position position = sci.CurrentPos();
+    std::string         piece;
+    auto insert = [&](std::string_view converted) {
+        piece.assign(converted);
+        sci.InsertText(position, piece.data());
+        position += piece.length();
+    };
+    StreamFromWide converter(sci.CodePage(), 1 << 18);
+    sci.BeginUndoAction();
+    try { converter.convert(filenames, true, insert); }
+    catch (...) {
+        sci.EndUndoAction();
+        throw;
+    }
+    sci.EndUndoAction();
+}
+
+
+// Start or stop recording a trace; when stopping, write the trace beside the configuration file
+
+void toggleTrace() {
+    if (!Trace::on()) {
+        Trace::start();
+        npp(NPPM_SETMENUITEMCHECK, menuDefinition[menuItem_ToggleTrace]._cmdID, 1);
+        return;
     }
-    sci.InsertText(-1, fromWide(filenames).data());
-}
\ No newline at end of file
+    Trace::stop();
+    npp(NPPM_SETMENUITEMCHECK, menuDefinition[menuItem_ToggleTrace]._cmdID, 0);
+    std::wstring path = saveTrace();
+    if (path.empty()) MessageBox(plugin.nppData._nppHandle, L"The trace could not be saved.", L"$projectname$", MB_ICONWARNING);
+    else MessageBox(plugin.nppData._nppHandle,
+        (L"The trace was saved to:\n\n" + path + L"\n\nOpen it in chrome://tracing or https://ui.perfetto.dev.").data(),
+        L"$projectname$", MB_ICONINFORMATION);
+}
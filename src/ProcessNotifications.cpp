@@ -15,9 +15,20 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "CommonData.h"
+#include <algorithm>
 
 extern void updateStatusDialog();
 extern void updateWatcherPanel();
+extern void watcherModified(const Scintilla::NotificationData*);
+extern void watcherGlobalModified(UINT_PTR);
+
+namespace {
+
+// The setting comes from the configuration file, which might hold any number; a negative value would become an
+// unsigned delay of weeks
+unsigned int refreshLatency() { return static_cast<unsigned int>(std::clamp(data.refreshLatency.get(), 0, 10000)); }
+
+}
 
 
 void scnModified(const Scintilla::NotificationData* scnp) {
@@ -25,8 +36,9 @@ void scnModified(const Scintilla::NotificationData* scnp) {
     if (FlagSet(scnp->modificationType, Scintilla::ModificationFlags::InsertText)) ++data.insertsCounted;
     else if (FlagSet(scnp->modificationType, Scintilla::ModificationFlags::DeleteText)) ++data.deletesCounted;
     else return;
-    updateStatusDialog();
-    updateWatcherPanel();
+    watcherModified(scnp);
+    RefreshScheduler::request(updateStatusDialog, refreshLatency());
+    RefreshScheduler::request(updateWatcherPanel, refreshLatency());
 }
 
 
@@ -63,18 +75,10 @@ void fileOpened(const NMHDR* nmhdr) {
 
 
 void modifyAll(const NMHDR* nmhdr) {
-    // This message is sent once for each buffer ID in which text is modified; the same buffer could be visible in both views
+    // This message is sent once for each buffer ID in which text is modified by an operation, such as Replace All since
+    // Notepad++ 8.6.5, which does not send Scintilla::Notification::Modified for each change
     UINT_PTR bufferID = reinterpret_cast<UINT_PTR>(nmhdr->hwndFrom);
-    intptr_t cdi1 = npp(NPPM_GETCURRENTDOCINDEX, 0, 0);
-    intptr_t cdi2 = npp(NPPM_GETCURRENTDOCINDEX, 0, 1);
-    bool visible1 = cdi1 < 0 ? false : bufferID == static_cast<UINT_PTR>(npp(NPPM_GETBUFFERIDFROMPOS, cdi1, 0));
-    bool visible2 = cdi2 < 0 ? false : bufferID == static_cast<UINT_PTR>(npp(NPPM_GETBUFFERIDFROMPOS, cdi2, 1));
-    if (visible1) {
-        plugin.getScintillaPointers(plugin.nppData._scintillaMainHandle);
-        // process changed visible main view
-    }
-    if (visible2) {
-        plugin.getScintillaPointers(plugin.nppData._scintillaSecondHandle);
-        // process changed visible secondary view
-    }
+    watcherGlobalModified(bufferID);
+    RefreshScheduler::request(updateStatusDialog, refreshLatency());
+    RefreshScheduler::request(updateWatcherPanel, refreshLatency());
 }
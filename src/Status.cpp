@@ -17,15 +17,43 @@
 #include "CommonData.h"
 #include "resource.h"
 #include "Shlwapi.h"
+#include <algorithm>
+#include <format>
 
 extern NPP::FuncItem menuDefinition[];  // Defined in Plugin.cpp
 extern int menuItem_ToggleStatus;       // Defined in Plugin.cpp
 
+void saveInstrumentation();             // Defined in Configuration.cpp
+void updateStatusDialog();
+
 
 namespace {
 
 HWND statusDialog = 0;
 
+constexpr size_t   slowestShown  = 8;     // number of paths listed when measuring latency
+constexpr UINT_PTR slowestTimer  = 1;
+constexpr UINT     slowestUpdate = 1000;  // milliseconds between updates of the list
+
+std::wstring formatMicroseconds(double t) {
+    return t >= 1000 ? std::format(L"{:.1f} ms", t / 1000) : std::format(L"{:.1f} \u00B5s", t);
+}
+
+std::wstring slowestPaths() {
+    std::vector<Instrumentation::Summary> events = Instrumentation::snapshot();
+    size_t shown = std::min(events.size(), slowestShown);
+    std::partial_sort(events.begin(), events.begin() + shown, events.end(),
+                      [](const auto& a, const auto& b) { return a.p99 > b.p99; });
+    std::wstring text;
+    for (size_t i = 0; i < shown; ++i) {
+        const Instrumentation::Summary& e = events[i];
+        std::string name = e.name ? e.name : std::format("{} {}", Instrumentation::kindName(e.kind), e.id);
+        text += std::format(L"{}, max {}, {} calls: ", formatMicroseconds(e.p99), formatMicroseconds(e.max), e.count)
+              + std::wstring(name.begin(), name.end()) + L"\r\n";
+    }
+    return text;
+}
+
 INT_PTR CALLBACK statusDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM) {
 
     switch (uMsg) {
@@ -44,6 +72,8 @@ INT_PTR CALLBACK statusDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM
         npp(NPPM_MODELESSDIALOG, MODELESSDIALOGADD, hwndDlg);
         npp(NPPM_DARKMODESUBCLASSANDTHEME, NPP::NppDarkMode::dmfInit, hwndDlg);  // Include to support dark mode
         npp(NPPM_SETMENUITEMCHECK, menuDefinition[menuItem_ToggleStatus]._cmdID, 1);
+        data.measureLatency.put(hwndDlg, IDC_STATUS_MEASURE);
+        SetTimer(hwndDlg, slowestTimer, slowestUpdate, 0);
         return TRUE;
     }
 
@@ -52,14 +82,26 @@ INT_PTR CALLBACK statusDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM
         case IDCANCEL:
             npp(NPPM_MODELESSDIALOG, MODELESSDIALOGREMOVE, hwndDlg);
             npp(NPPM_SETMENUITEMCHECK, menuDefinition[menuItem_ToggleStatus]._cmdID, 0);
+            KillTimer(hwndDlg, slowestTimer);
             DestroyWindow(hwndDlg);
             statusDialog = 0;
             return TRUE;
         case IDOK:
             SetFocus(plugin.currentScintilla());                // make Enter key return to active edit window
             return TRUE;
+        case IDC_STATUS_MEASURE:
+            Instrumentation::enabled = data.measureLatency.get(hwndDlg, IDC_STATUS_MEASURE);
+            updateStatusDialog();
+            return TRUE;
+        case IDC_STATUS_SAVE:
+            saveInstrumentation();
+            return TRUE;
         }
         return FALSE;
+
+    case WM_TIMER:
+        if (wParam == slowestTimer && Instrumentation::on()) updateStatusDialog();
+        return TRUE;
     }
 
     return FALSE;
@@ -72,6 +114,7 @@ void updateStatusDialog() {
     if (!statusDialog) return;
     SetDlgItemInt(statusDialog, IDC_STATUS_INSERTS, data.insertsCounted, true);
     SetDlgItemInt(statusDialog, IDC_STATUS_DELETES, data.deletesCounted, true);
+    SetDlgItemText(statusDialog, IDC_STATUS_SLOWEST, slowestPaths().data());
 }
 
 void toggleStatusDialog() {
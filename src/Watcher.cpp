@@ -15,45 +15,279 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "CommonData.h"
+#include "Framework/AhoCorasick.h"
+#include "Framework/DocumentView.h"
+#include "Framework/ParallelSearch.h"
+#include "Framework/RefreshScheduler.h"
 #include "resource.h"
 #include "Shlwapi.h"
+#include <memory>
 
 extern NPP::FuncItem menuDefinition[];  // Defined in Plugin.cpp
 extern int menuItem_ToggleWatcher;      // Defined in Plugin.cpp
 
+void updateWatcherPanel();
+
 
 namespace {
 
 HWND watcherPanel = 0;
 
-Scintilla::Position location = -1;
-Scintilla::Position terminal = -1;
+// The watcher accepts a list of words separated by | characters, and finds every whole-word instance of any of them (by
+// the rule Scintilla uses for FindOption::WholeWord, with word, space and punctuation characters read from Scintilla)
+// in one pass through the document using an Aho-Corasick automaton.  Like Notepad++'s search without "Match case," it
+// ignores case, though only for ASCII letters, since the automaton compares bytes.  It keeps a list of all the
+// instances, adjusting their positions as the document changes, so most edits require searching only the text around
+// the edit.  For each insertion or deletion, watcherModified removes instances which the edit touches and adds the
+// edited text, plus enough on either side to include any instance which overlaps it, to the "unsearched" range.
+// Outside that range, the list of instances is correct.  Notepad++ makes some changes (such as Replace All, since
+// version 8.6.5) without sending Scintilla modification notifications; for those, watcherGlobalModified marks the whole
+// document unsearched.
+//
+// The unsearched range is searched from its start in slices of at most sliceLength bytes, reading the document in place
+// through DocumentView.  Each slice is searched while the user interface thread waits, so Scintilla cannot change the
+// text while it is being read; unless the "Watcher search threads" setting is 1, slices use parallelSearch, which
+// divides the slice among the calling thread and several of the framework's taskPool threads.  After each slice, the
+// instances found are applied and the unsearched range shrinks to start where an instance which crosses the end of the
+// slice could begin.  Slices are searched until sliceTime has passed or input is waiting; then the rest waits for
+// RefreshScheduler, which runs only when no other messages are waiting.  So the search delays typing by at most one
+// slice, and an edit in the meantime neither discards what has been found nor restarts the search: watcherModified just
+// moves the unsearched range, or widens it to include the edit, like any other edit.
+//
+// Scintilla's buffer has a gap at the last edit.  A slice whose text would span the gap is cut short at the gap,
+// unless it starts within a few words' length of the gap; then DocumentView::window moves the gap to the slice's
+// start, which moves only the few bytes between them.
+//
+// When "Mark all instances" is checked, instances are marked with an indicator.  Scintilla moves indicators along
+// with the text, so marks need to be repainted only in the ranges which are searched again.  The < and > buttons
+// select the previous or next instance, found by binary search in the list of instances.
+
+using Scintilla::Position;
+
+constexpr Position  unbounded       = PTRDIFF_MAX;
+constexpr Position  sequentialLimit = 1 << 16;  // search shorter slices on the user interface thread alone
+constexpr Position  sliceLength     = 1 << 22;  // longest range to search before checking for input
+constexpr size_t    chunkLength     = 1 << 18;  // part of a slice each thread takes at a time in parallelSearch
+constexpr ULONGLONG sliceTime       = 20;       // milliseconds to keep searching before yielding to other messages
+
+struct Hit {
+    Position position;
+    size_t   term;
+    bool operator<(const Hit& other) const { return position < other.position; }
+};
+
+std::vector<Hit>    hits;                // every instance of a watched word, in order of position
+std::vector<size_t> counts;              // number of instances of each watched word
+
+HWND                               watchedView     = 0;  // Scintilla control, document, text and length last searched
+intptr_t                           watchedDocument = 0;
+UINT_PTR                           watchedBuffer   = 0;  // Notepad++ buffer ID of watchedDocument
+std::wstring                       watchedText;
+Position                           watchedLength   = -1;
+std::vector<std::wstring>          watchedWords;
+std::shared_ptr<const AhoCorasick> automaton       = std::make_shared<AhoCorasick>();
+Position                           reach           = 1;  // longest watched word, plus one for a word boundary
+Position                           unsearchedStart = 0;
+Position                           unsearchedEnd   = unbounded;
+
+uint8_t charClass[256];  // Scintilla's class for each byte, as parallelSearch uses
+
+int indicator = -1;  // allocated from Notepad++ when first needed
 
 DialogStretch stretch;
 
-void updateWatcherPanelUnconditional() {
-    std::wstring text = GetDlgItemString(watcherPanel, IDC_WATCHER_TEXT);
-    if (text.empty()) {
+
+void unsearched(Position start, Position end) {
+    if (start < 0) start = 0;
+    if (unsearchedStart >= unsearchedEnd) {
+        unsearchedStart = start;
+        unsearchedEnd   = end;
+    }
+    else {
+        unsearchedStart = std::min(unsearchedStart, start);
+        unsearchedEnd   = std::max(unsearchedEnd  , end  );
+    }
+}
+
+void watchText(const std::wstring& text) {
+    watchedText = text;
+    watchedWords.clear();
+    std::vector<std::string> bytes;
+    for (size_t i = 0; i <= text.length();) {
+        size_t j = std::min(text.find(L'|', i), text.length());
+        size_t a = text.find_first_not_of(L' ', i);
+        size_t b = text.find_last_not_of(L' ', j - 1);
+        if (a < j && b != std::wstring::npos && b >= a) {
+            std::wstring word = text.substr(a, b - a + 1);
+            if (std::find(watchedWords.begin(), watchedWords.end(), word) == watchedWords.end()) {
+                watchedWords.push_back(word);
+                bytes.push_back(fromWide(word));
+            }
+        }
+        i = j + 1;
+    }
+    automaton = std::make_shared<AhoCorasick>(bytes, false);
+    reach = static_cast<Position>(automaton->longest()) + 1;
+}
+
+void prepareIndicator() {
+    if (indicator >= 0) return;
+    int first = 0;
+    indicator = npp(NPPM_ALLOCATEINDICATOR, 1, &first) ? first : static_cast<int>(Scintilla::IndicatorNumbers::Container);
+    for (HWND view : { plugin.nppData._scintillaMainHandle, plugin.nppData._scintillaSecondHandle }) {
+        plugin.getScintillaPointers(view);
+        sci.IndicSetStyle(indicator, Scintilla::IndicatorStyle::RoundBox);
+        sci.IndicSetFore (indicator, 0x00C0FF);
+        sci.IndicSetAlpha(indicator, static_cast<Scintilla::Alpha>(96));
+        sci.IndicSetUnder(indicator, true);
+    }
+}
+
+void paintMarks(Position start, Position end, const std::vector<Hit>& marks) {
+    if (!data.watcherMarkAll) return;
+    prepareIndicator();
+    plugin.getScintillaPointers();
+    Scintilla::ScintillaBatch batch;
+    batch.add(Scintilla::Message::SetIndicatorCurrent, indicator)
+         .add(Scintilla::Message::IndicatorClearRange, start, end - start);
+    for (const Hit& hit : marks) {
+        batch.add(Scintilla::Message::IndicatorFillRange, hit.position, automaton->termLength(hit.term));
+        if (batch.size() >= 1024) {
+            plugin.send(batch);
+            batch.clear();
+        }
+    }
+    plugin.send(batch);
+}
+
+void clearMarks() {
+    if (indicator < 0) return;
+    plugin.getScintillaPointers();
+    sci.SetIndicatorCurrent(indicator);
+    sci.IndicatorClearRange(0, sci.Length());
+}
+
+void selectInstance(bool next) {
+    if (hits.empty()) return;
+    plugin.getScintillaPointers();
+    auto hit = std::lower_bound(hits.begin(), hits.end(), Hit{ next ? sci.SelectionEnd() : sci.SelectionStart(), 0 });
+    if (next) { if (hit == hits.end()) hit = hits.begin(); }
+    else hit = hit == hits.begin() ? hits.end() - 1 : hit - 1;
+    sci.SetSel(hit->position, hit->position + static_cast<Position>(automaton->termLength(hit->term)));
+}
+
+void showResults() {
+    if (watchedWords.empty()) {
         SetDlgItemText(watcherPanel, IDC_WATCHER_RESULT, L"");
-        location = -1;
         return;
     }
+    std::vector<Position> firsts(watchedWords.size(), -1);
+    size_t unfound = 0;
+    for (size_t count : counts) if (count) ++unfound;
+    for (auto hit = hits.begin(); unfound && hit != hits.end(); ++hit) if (firsts[hit->term] < 0) {
+        firsts[hit->term] = hit->position;
+        --unfound;
+    }
     plugin.getScintillaPointers();
-    std::string s = fromWide(text);
-    sci.TargetWholeDocument();
-    sci.SetSearchFlags(Scintilla::FindOption::WholeWord);
-    location = sci.SearchInTarget(s);
-    if (location < 0) {
-        SetDlgItemText(watcherPanel, IDC_WATCHER_RESULT, (L"\"" + text + L"\" not found.").data());
-        return;
+    std::wstring result;
+    for (size_t i = 0; i < watchedWords.size(); ++i) {
+        if (i) result += L"\r\n";
+        if (firsts[i] < 0) result += L"\"" + watchedWords[i] + L"\" not found.";
+        else {
+            std::wstring linenum = std::to_wstring(sci.LineFromPosition(firsts[i]) + 1);
+            result += L"Found \"" + watchedWords[i] + L"\" on line " + linenum;
+            result += counts[i] > 1 ? L" (" + std::to_wstring(counts[i]) + L" instances)." : L".";
+        }
     }
-    terminal = sci.TargetEnd();
-    std::wstring linenum = std::to_wstring(sci.LineFromPosition(location) + 1);
-    SetDlgItemText(watcherPanel, IDC_WATCHER_RESULT, (L"Found \"" + text + L"\" on line " + linenum + L".").data());
+    if (unsearchedStart < unsearchedEnd) result += L"\r\nSearching...";
+    SetDlgItemText(watcherPanel, IDC_WATCHER_RESULT, result.data());
+}
+
+void applySearch(Position start, Position end, const std::vector<Hit>& found) {
+    // Instances entirely within the range searched are found again; others were not affected by the edits
+    auto first = std::lower_bound(hits.begin(), hits.end(), Hit{ start, 0 });
+    auto stop  = std::lower_bound(first, hits.end(), Hit{ end, 0 });
+    auto kept  = std::remove_if(first, stop, [&](const Hit& hit) {
+        if (hit.position + static_cast<Position>(automaton->termLength(hit.term)) > end) return false;
+        --counts[hit.term];
+        return true;
+    });
+    const size_t lower  = first - hits.begin();
+    const size_t middle = kept  - hits.begin();
+    hits.erase(kept, stop);
+    for (const Hit& hit : found) ++counts[hit.term];
+    hits.insert(hits.begin() + middle, found.begin(), found.end());
+    std::inplace_merge(hits.begin() + lower, hits.begin() + middle, hits.begin() + middle + found.size());
+    if (!data.watcherMarkAll) return;
+    // Repaint every instance the range overlaps, since paintMarks clears the range; some begin before it
+    std::vector<Hit> marks;
+    for (auto hit = std::lower_bound(hits.begin(), hits.end(), Hit{ start - reach, 0 }); hit != hits.end() && hit->position < end; ++hit)
+        if (hit->position + static_cast<Position>(automaton->termLength(hit->term)) > start) marks.push_back(*hit);
+    paintMarks(start, end, marks);
 }
 
+// Searches a slice from the start of the unsearched range, applies the result and removes the slice from the range
 
-INT_PTR CALLBACK watcherDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM) {
+void searchSlice(Position length) {
+    DocumentView document(plugin.directStatusScintilla, plugin.pointerScintilla);
+    const Position gap   = static_cast<Position>(document.part1().length());
+    const Position start = unsearchedStart;
+    Position       end   = std::min({ unsearchedEnd, length, start + std::max(sliceLength, 2 * reach) });
+    const Position from  = std::max<Position>(start - 1, 0);  // include the characters on either side, for word boundaries
+    if (from < gap && gap < std::min(end + 1, length) && gap - start > 2 * reach) end = gap - 1;
+    const Position to    = std::min(end + 1, length);
+    const std::string_view text = document.window(from, to - from);
+
+    std::vector<ParallelSearchHit> matches;
+    const unsigned threads = static_cast<unsigned>(std::max(data.watcherThreads.get(), 0));
+    if (threads == 1 || end - start < sequentialLimit) sequentialSearch(text, start - from, end - from, *automaton, charClass, matches);
+    else parallelSearch(taskPool, text, start - from, end - from, *automaton, charClass, matches, [] { return false; }, threads, chunkLength);
+    std::vector<Hit> found;
+    found.reserve(matches.size());
+    for (const ParallelSearchHit& match : matches) found.push_back({ static_cast<Position>(match.position) + from, match.term });
+    applySearch(start, end, found);
+
+    // Instances which begin in the slice but end after it have not been found yet
+    if (end >= std::min(unsearchedEnd, length)) unsearchedStart = unsearchedEnd = 0;
+    else unsearchedStart = end - static_cast<Position>(automaton->longest()) + 1;
+}
+
+void updateWatcherPanelUnconditional() {
+    std::wstring text = GetDlgItemString(watcherPanel, IDC_WATCHER_TEXT);
+    plugin.getScintillaPointers();
+    HWND     view     = plugin.currentScintilla();
+    intptr_t document = reinterpret_cast<intptr_t>(sci.DocPointer());
+    Position length   = sci.Length();
+    if (view != watchedView || document != watchedDocument || text != watchedText || length != watchedLength) {
+        // Changes were made which watcherModified did not see (or they were made to some other document or text)
+        watchText(text);  // the document's code page might be different
+        watchedView     = view;
+        watchedDocument = document;
+        watchedBuffer   = static_cast<UINT_PTR>(npp(NPPM_GETCURRENTBUFFERID, 0, 0));
+        watchedLength   = length;
+        hits.clear();
+        counts.assign(watchedWords.size(), 0);
+        clearMarks();
+        unsearchedStart = 0;
+        unsearchedEnd   = unbounded;
+    }
+    if (watchedWords.empty() || unsearchedStart >= std::min(unsearchedEnd, length)) {
+        unsearchedStart = unsearchedEnd = 0;
+        showResults();
+        return;
+    }
+    std::fill(std::begin(charClass), std::end(charClass), parallelsearch::newLine);
+    for (char c : sci.WhitespaceChars ()) charClass[static_cast<uint8_t>(c)] = parallelsearch::space;
+    for (char c : sci.WordChars       ()) charClass[static_cast<uint8_t>(c)] = parallelsearch::word;
+    for (char c : sci.PunctuationChars()) charClass[static_cast<uint8_t>(c)] = parallelsearch::punctuation;
+    const ULONGLONG due = GetTickCount64() + sliceTime;
+    do searchSlice(length);
+    while (unsearchedStart < unsearchedEnd && GetTickCount64() < due && !HIWORD(GetQueueStatus(QS_INPUT)));
+    if (unsearchedStart < unsearchedEnd) RefreshScheduler::request(updateWatcherPanel, 0);
+    showResults();
+}
+
+INT_PTR CALLBACK watcherDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 
     switch (uMsg) {
 
@@ -62,6 +296,7 @@ INT_PTR CALLBACK watcherDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARA
         return TRUE;
 
     case WM_INITDIALOG:
+        data.watcherMarkAll.put(hwndDlg, IDC_WATCHER_ALL);
         stretch.setup(hwndDlg);
         npp(NPPM_MODELESSDIALOG, MODELESSDIALOGADD, hwndDlg);   // a docking dialog must be a modeless dialog
         return TRUE;
@@ -73,9 +308,10 @@ INT_PTR CALLBACK watcherDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARA
             return TRUE;
         case IDOK:
             SetFocus(plugin.currentScintilla());                // make Enter key return to active edit window
-            if (location >= 0) {                                // and if the word was found
+            if (!hits.empty()) {                                // and if a word was found
+                const Hit& hit = hits.front();                  // select the first instance
                 plugin.getScintillaPointers();
-                sci.SetSel(location, terminal);                 // select the first instance
+                sci.SetSel(hit.position, hit.position + static_cast<Position>(automaton->termLength(hit.term)));
             }
             return TRUE;
         case IDC_WATCHER_TEXT:
@@ -83,16 +319,32 @@ INT_PTR CALLBACK watcherDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARA
                 updateWatcherPanelUnconditional();
                 return TRUE;
             }
+            break;
+        case IDC_WATCHER_ALL:
+            if (data.watcherMarkAll.get(hwndDlg, IDC_WATCHER_ALL)) {
+                plugin.getScintillaPointers();
+                paintMarks(0, sci.Length(), hits);
+            }
+            else clearMarks();
+            return TRUE;
+        case IDC_WATCHER_PREVIOUS:
+            selectInstance(false);
+            return TRUE;
+        case IDC_WATCHER_NEXT:
+            selectInstance(true);
+            return TRUE;
         }
         return FALSE;
 
     case WM_SHOWWINDOW:
         if (wParam) updateWatcherPanelUnconditional();
+        else clearMarks();
         npp(NPPM_SETMENUITEMCHECK, menuDefinition[menuItem_ToggleWatcher]._cmdID, wParam ? 1 : 0);
         return FALSE;
 
     case WM_SIZE:
-        stretch.adjust(IDC_WATCHER_TEXT, 1).adjust(IDC_WATCHER_RESULT, 1);
+        stretch.adjust(IDC_WATCHER_TEXT, 1).adjust(IDC_WATCHER_RESULT, 1, 1)
+               .adjust(IDC_WATCHER_PREVIOUS, 0, 0, 1).adjust(IDC_WATCHER_NEXT, 0, 0, 1);
         return FALSE;
 
     }
@@ -105,6 +357,53 @@ INT_PTR CALLBACK watcherDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARA
 
 void updateWatcherPanel() { if (watcherPanel && IsWindowVisible(watcherPanel)) updateWatcherPanelUnconditional(); }
 
+void watcherModified(const Scintilla::NotificationData* scnp) {
+    if (!watchedView || reinterpret_cast<HWND>(scnp->nmhdr.hwndFrom) != watchedView) return;
+    if (!IsWindowVisible(watcherPanel)) {
+        watchedView = 0;  // don't track changes while hidden; search again when shown
+        return;
+    }
+    using Scintilla::FlagSet;
+    const Position p = scnp->position;
+    const Position n = scnp->length;
+    const bool insert = FlagSet(scnp->modificationType, Scintilla::ModificationFlags::InsertText);
+    if (!insert && !FlagSet(scnp->modificationType, Scintilla::ModificationFlags::DeleteText)) return;
+
+    // An instance is touched if the edit is within it or adjacent to it; instances after the edit move
+
+    const Position shift = insert ? n : -n;
+    const Position after = insert ? p : p + n;
+    auto kept = std::lower_bound(hits.begin(), hits.end(), Hit{ p - reach, 0 });
+    for (auto hit = kept; hit != hits.end(); ++hit) {
+        if (hit->position > after) hit->position += shift;
+        else if (hit->position + static_cast<Position>(automaton->termLength(hit->term)) >= p) {
+            --counts[hit->term];
+            continue;
+        }
+        *kept++ = *hit;
+    }
+    hits.erase(kept, hits.end());
+
+    watchedLength += shift;
+    if (unsearchedStart < unsearchedEnd) {
+        if (insert) {
+            if (unsearchedStart >= p) unsearchedStart += n;
+            if (unsearchedEnd > p && unsearchedEnd != unbounded) unsearchedEnd += n;
+        }
+        else {
+            auto map = [&](Position x) { return x <= p ? x : x == unbounded ? x : std::max(p, x - n); };
+            unsearchedStart = map(unsearchedStart);
+            unsearchedEnd   = map(unsearchedEnd);
+        }
+    }
+    unsearched(p - reach, p + (insert ? n : 0) + reach);
+}
+
+void watcherGlobalModified(UINT_PTR buffer) {
+    if (!watchedView || buffer != watchedBuffer) return;
+    watchedView = 0;  // search the whole document at the next update
+}
+
 void toggleWatcherPanel() {
     if (!watcherPanel) {
         watcherPanel = CreateDialog(plugin.dllInstance, MAKEINTRESOURCE(IDD_WATCHER), plugin.nppData._nppHandle, watcherDialogProc);
@@ -124,3 +423,5 @@ void toggleWatcherPanel() {
         npp(NPPM_DMMSHOW, 0, watcherPanel);
     }
 }
+
+void stopWatcherSearch() { RefreshScheduler::cancel(updateWatcherPanel); }  // don't search the rest of the range
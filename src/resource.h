@@ -22,6 +22,12 @@
 #define IDC_WATCHER_RESULT              1015
 #define IDC_EDIT1                       1016
 #define IDC_WATCHER_TEXT                1017
+#define IDC_WATCHER_ALL                 1018
+#define IDC_WATCHER_PREVIOUS            1019
+#define IDC_WATCHER_NEXT                1020
+#define IDC_STATUS_MEASURE              1021
+#define IDC_STATUS_SAVE                 1022
+#define IDC_STATUS_SLOWEST              1023
 
 // Next default values for new objects
 // 
@@ -29,7 +35,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        107
 #define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1018
+#define _APS_NEXT_CONTROL_VALUE         1024
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif
@@ -0,0 +1,101 @@
+// This file is part of "NppCppMSVS: Visual Studio Project Template for a Notepad++ C++ Plugin"
+// Copyright 2025 by Randall Joseph Fellmy <software@coises.com>, <http://www.coises.com/software/>
+
+// The source code contained in this file is independent of Notepad++ code.
+// It is released under the MIT (Expat) license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+// associated documentation files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or substantial 
+// portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Compares parallelSearch with sequentialSearch, and sequentialSearch with a naive search, on random texts, terms and
+// ranges.  Texts use a small alphabet, so instances are frequent, and chunks are small, so many instances cross chunk
+// boundaries and the end of the range.
+//
+// This is a console program, not part of the plugin; build and run it from the repository root with, for example,
+//     cl /std:c++20 /EHsc /O2 /Isrc test\ParallelSearchTest.cpp
+//     g++ -std=c++20 -O2 -pthread -Isrc test/ParallelSearchTest.cpp
+// It prints the first difference found, if any, and returns a nonzero exit code if there was one.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include "Framework/ParallelSearch.h"
+
+int main(int argc, char** argv) {
+    const unsigned rounds = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], 0, 10)) : 5000;
+    const unsigned seed   = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], 0, 10)) : 1;
+    std::mt19937 random(seed);
+    auto pick = [&](size_t n) { return std::uniform_int_distribution<size_t>(0, n)(random); };  // 0 through n
+    uint8_t charClass[256];
+    std::fill(std::begin(charClass), std::end(charClass), parallelsearch::punctuation);
+    for (char c : std::string("abcAB")) charClass[static_cast<uint8_t>(c)] = parallelsearch::word;
+    charClass[' '] = parallelsearch::space;
+    charClass['\n'] = parallelsearch::newLine;
+    const char alphabet[] = "abcAB -.\n";
+    auto same = [](const ParallelSearchHit& a, const ParallelSearchHit& b) { return a.position == b.position && a.term == b.term; };
+    auto order = [](const ParallelSearchHit& a, const ParallelSearchHit& b) { return a.position != b.position ? a.position < b.position : a.term < b.term; };
+    TaskPool pool;
+    for (unsigned round = 0; round < rounds; ++round) {
+        std::string text(pick(4000), 0);
+        for (char& c : text) c = alphabet[pick(8)];
+        std::vector<std::string> terms;
+        for (size_t n = 1 + pick(3); terms.size() < n;) {
+            std::string term(1 + pick(4), 0);
+            for (char& c : term) c = alphabet[pick(8)];
+            if (std::find(terms.begin(), terms.end(), term) == terms.end()) terms.push_back(term);
+        }
+        const bool matchCase = round & 2;
+        AhoCorasick automaton(terms, matchCase);
+        const size_t start = pick(text.length());
+        const size_t end   = start + pick(text.length() - start + 2);  // sometimes past the end of the text
+        const size_t chunk = 1 + pick(64);
+        const uint8_t* words = round & 1 ? charClass : nullptr;
+        std::vector<ParallelSearchHit> naive, expected, actual;
+        auto classAt = [&](size_t p) { return charClass[static_cast<uint8_t>(text[p])]; };
+        auto isStart = [&](size_t p) {  // Scintilla's Document::IsWordStartAt and IsWordEndAt
+            return p == 0 || ((classAt(p) == parallelsearch::word || classAt(p) == parallelsearch::punctuation) && classAt(p) != classAt(p - 1));
+        };
+        auto isEnd = [&](size_t p) {
+            return p == text.length() || ((classAt(p - 1) == parallelsearch::word || classAt(p - 1) == parallelsearch::punctuation) && classAt(p) != classAt(p - 1));
+        };
+        for (size_t p = start; p < std::min(end, text.length()); ++p) for (size_t i = 0; i < terms.size(); ++i) {
+            const size_t finish = p + terms[i].length();
+            if (finish > std::min(end, text.length())) continue;
+            bool match = true;
+            for (size_t k = 0; match && k < terms[i].length(); ++k) {
+                char a = text[p + k], b = terms[i][k];
+                match = matchCase ? a == b : AhoCorasick::fold(a) == AhoCorasick::fold(b);
+            }
+            if (match && (!words || (isStart(p) && isEnd(finish)))) naive.push_back({ p, i });
+        }
+        sequentialSearch(text, start, end, automaton, words, expected);
+        parallelSearch(pool, text, start, end, automaton, words, actual, [] { return false; }, 0, chunk);
+        const char* problem = 0;
+        std::vector<ParallelSearchHit> sorted = expected;
+        std::sort(sorted.begin(), sorted.end(), order);
+        if (!std::equal(naive.begin(), naive.end(), sorted.begin(), sorted.end(), same)) problem = "naive search";
+        else if (!std::equal(expected.begin(), expected.end(), actual.begin(), actual.end(), same)) problem = "parallelSearch";
+        if (problem) {
+            std::printf("Round %u: range %zu to %zu, chunk %zu, %s, %s: sequentialSearch found %zu, %s found %zu\n",
+                        round, start, end, chunk, words ? "whole words" : "anywhere", matchCase ? "match case" : "ignore case",
+                        expected.size(), problem, problem[0] == 'n' ? naive.size() : actual.size());
+            return 1;
+        }
+    }
+    std::printf("%u rounds: no differences\n", rounds);
+    return 0;
+}